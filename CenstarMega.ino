@@ -1,26 +1,50 @@
 // CenstarMega.ino
 #include <Arduino.h>
 #include "config.h"
+#include "bench.h"
 #include "fsm.h"
 #include "keypad.h"
 #include "oled.h"
-#include "rs422.h"
+#include "pump.h"
+#include "screen.h"
 
-static FSMContext fsmContext;
+// Один автомат на каждый пост шины
+static FSMContext posts[POST_COUNT];
+static uint8_t selectedPost = 0;
 static unsigned long welcomeUntil = 0;
 static bool welcomeShown = false;
+static unsigned long lastBusReport = 0;
 
 void setup() {
     Serial.begin(9600);
     initOLED();
-    initRS422();
-    initFSM(&fsmContext);
-    displayMessage("CENSTAR");
+    PumpDriver::init();
+    for (uint8_t i = 0; i < POST_COUNT; i++) {
+        initFSM(&posts[i], i);
+    }
+    // Цена поста в ОЗУ; предел проверяется static_assert в fsm.h
+    Serial.print("FSM context: ");
+    Serial.print(sizeof(FSMContext));
+    Serial.print(" bytes/post, total ");
+    Serial.println(sizeof(posts));
+#if BENCHMARK_ON_START
+    runBenchmarks();
+#endif
+    screenShowText(TEXT_WELCOME);
     welcomeUntil = millis() + DISPLAY_WELCOME_DURATION;
     welcomeShown = true;
 }
 
 void loop() {
+    // Обмен с ТРК идёт в фоне: приём ответов, колбэки, отправка следующего запроса
+    PumpDriver::service();
+#if PUMP_DRIVER == PUMP_DRIVER_MOCK
+    mockPumpConsole();
+#endif
+    // Модель экрана уходит на дисплей не чаще DISPLAY_FRAME_INTERVAL; oledService() передаёт кадр по байту, когда шина TWI свободна
+    screenService();
+    oledService();
+
     // Неблокирующее завершение приветствия
     if (welcomeShown && millis() >= welcomeUntil) {
         welcomeShown = false;
@@ -28,9 +52,24 @@ void loop() {
 
     if (!welcomeShown) {
         char key = getKeypadKey();
-        if (key) {
-            processKeyFSM(&fsmContext, key);
+        if (key == 'F' || key == 'H') {
+            // Выбор поста, которому принадлежат дисплей и клавиатура
+            selectedPost = (key == 'H') ? (selectedPost + 1) % POST_COUNT
+                                        : (selectedPost + POST_COUNT - 1) % POST_COUNT;
+            fsmAttachDisplay(&posts[selectedPost]);
+        } else if (key) {
+            processKeyFSM(&posts[selectedPost], key);
+        }
+        for (uint8_t i = 0; i < POST_COUNT; i++) {
+            updateFSM(&posts[i]);
         }
-        updateFSM(&fsmContext);
+    }
+
+    if (millis() - lastBusReport >= BUS_REPORT_INTERVAL) {
+        lastBusReport = millis();
+        PumpDriver::reportStats();
+        fsmReportStats();
+        oledReportStats();
+        screenReportStats();
     }
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+// bench.cpp
+#include "bench.h"
+#include "config.h"
+#include "utils.h"
+#include "oled.h"
+#include <avr/io.h>
+
+#define BENCH_RUNS 16           // Повторов каждого случая (берётся среднее)
+
+// Прежний разбор поля: копия в строку, проверка цифр, atol
+static bool referenceParse(const uint8_t* src, uint8_t width, uint32_t* value) {
+    char field[12];
+    for (uint8_t i = 0; i < width; i++) {
+        if (src[i] < '0' || src[i] > '9') return false;
+        field[i] = src[i];
+    }
+    field[width] = '\0';
+    *value = atol(field);
+    return true;
+}
+
+// Прежний вывод литров через snprintf
+static void referenceFormat(char* dst, uint32_t value) {
+    snprintf(dst, 12, "%lu.%02lu", (unsigned long)(value / 100), (unsigned long)(value % 100));
+}
+
+static const uint8_t sampleReply[] = "1234567";   // Поле суммы/объёма ответа T (6 цифр)
+static const uint8_t sampleCounter[] = "9876543210"; // Поле счётчика ответа C (9 цифр)
+static volatile uint32_t sink;  // Результаты не должны выбрасываться компилятором
+
+typedef void (*BenchCase)(uint8_t run);
+
+static void parseOld6(uint8_t) { uint32_t v; referenceParse(sampleReply, 6, &v); sink = v; }
+static void parseNew6(uint8_t) { uint32_t v; parseFixedDecimal(sampleReply, 6, &v); sink = v; }
+static void parseOld9(uint8_t) { uint32_t v; referenceParse(sampleCounter, 9, &v); sink = v; }
+static void parseNew9(uint8_t) { uint32_t v; parseFixedDecimal(sampleCounter, 9, &v); sink = v; }
+
+static void formatOld(uint8_t run) {
+    char buf[12];
+    referenceFormat(buf, 123456UL + run);
+    sink = buf[0];
+}
+
+static void formatNew(uint8_t run) {
+    char buf[12];
+    formatFixed(buf, 123456UL + run, 2);
+    sink = buf[0];
+}
+
+// Прежний экран налива: строка из статуса, литров и суммы шрифтом через перенос по словам
+static void displayOld(uint8_t run) {
+    char displayStr[48];
+    char* end = appendDisplayText(displayStr, TEXT_DISPENSING);
+    end = appendText(end, "\nL: ");
+    end = formatFixed(end, 1234UL + run, 2);
+    end = appendText(end, "\nP: ");
+    formatUnsigned(end, 61700UL + run * 50);
+    displayMessage(displayStr);
+}
+
+// Крупные цифры: копируются глифы только сменившихся знаков
+static void displayNew(uint8_t run) {
+    char liters[12];
+    char money[12];
+    formatFixed(liters, 1234UL + run, 2);
+    formatUnsigned(money, 61700UL + run * 50);
+    displayFigures(TEXT_DISPENSING, liters, money);
+}
+
+// Средняя стоимость вызова в тактах за вычетом пустого замера
+static uint16_t measure(BenchCase fn) {
+    uint32_t total = 0;
+    for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+        uint8_t sreg = SREG;
+        cli();
+        TCNT1 = 0;
+        fn(run);
+        uint16_t cycles = TCNT1;
+        SREG = sreg;
+        total += cycles;
+    }
+    return total / BENCH_RUNS;
+}
+
+static void empty(uint8_t) {}
+
+// Вывод на дисплей дольше 65536 тактов: таймер с делителем 8, прерывания не запрещаются
+// (без DISPLAY_ASYNC_FLUSH передача через Wire ждёт прерывания TWI). Перед каждым
+// вызовом дисплей дожидается конца предыдущего кадра, ожидание в замер не входит
+static uint32_t measureDisplay(BenchCase fn) {
+    uint32_t total = 0;
+    fn(BENCH_RUNS);             // Первый кадр рисуется целиком, в среднее не входит
+    for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+        while (oledBusy()) oledService();
+        TCCR1B = 1 << CS11;
+        TCNT1 = 0;
+        fn(run);
+        uint16_t ticks = TCNT1;
+        TCCR1B = 1 << CS10;
+        total += (uint32_t)ticks * 8;
+    }
+    while (oledBusy()) oledService();
+    return total / BENCH_RUNS;
+}
+
+static void report(const char* name, uint16_t before, uint16_t after, uint16_t overhead) {
+    Serial.print("Bench ");
+    Serial.print(name);
+    Serial.print(": old ");
+    Serial.print(before - overhead);
+    Serial.print(", new ");
+    Serial.print(after - overhead);
+    Serial.println(" cycles");
+}
+
+void runBenchmarks() {
+    uint8_t savedA = TCCR1A;
+    uint8_t savedB = TCCR1B;
+    TCCR1A = 0;
+    TCCR1B = 1 << CS10;         // Счёт тактов CPU без делителя
+    uint16_t overhead = measure(empty);
+    report("parse 6 digits", measure(parseOld6), measure(parseNew6), overhead);
+    report("parse 9 digits", measure(parseOld9), measure(parseNew9), overhead);
+    report("format liters", measure(formatOld), measure(formatNew), overhead);
+    uint32_t before = measureDisplay(displayOld);
+    uint32_t after = measureDisplay(displayNew);
+    Serial.print("Bench transaction screen update: old ");
+    Serial.print(before);
+    Serial.print(", new ");
+    Serial.print(after);
+    Serial.println(" cycles");
+    TCCR1A = savedA;
+    TCCR1B = savedB;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+
+/**
+ * Measures hot numeric paths in CPU cycles with Timer1 (no prescaler)
+ * and prints the old and new cost of each to the debug port. Each case
+ * runs with interrupts off and must stay under 65536 cycles per call.
+ * A transaction screen update (text path against large digits) is timed
+ * with the /8 prescaler and interrupts on; the display must be initialized.
+ * Timer1 settings are restored afterwards. Called from setup() when
+ * BENCHMARK_ON_START is set.
+ */
+void runBenchmarks();
+
+#endif
\ No newline at end of file
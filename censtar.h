@@ -0,0 +1,61 @@
+// censtar.h
+#ifndef CENSTAR_H
+#define CENSTAR_H
+
+#include "rs422.h"
+#include "rtt.h"
+#include "message.h"
+
+/**
+ * GasKitLink (Censtar) pump driver: requests go through the RS422 queue,
+ * replies are read in place by the message.h views. Every member is an
+ * inline forwarder, so a call through PumpDriver costs the same as
+ * calling rs422 directly.
+ */
+struct CenstarDriver {
+    typedef ::ReplyView ReplyView;
+    typedef ::StatusReply StatusReply;
+    typedef ::MonitorReply MonitorReply;
+    typedef ::TransactionEndReply TransactionEndReply;
+    typedef ::TotalCounterReply TotalCounterReply;
+
+    static void init() { initRS422(); }
+    static void service() { rs422Service(); }
+    static void setPriority(uint8_t address, bool dispensing) { rs422SetPostPriority(address, dispensing); }
+    static void reportStats() {
+        rs422ReportStats();
+        rttReport();
+    }
+
+    static bool pollStatus(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr) {
+        return rs422SendStatus(address, callback, context);
+    }
+    static bool probeStatus(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendProbe(address, callback, context);
+    }
+    static bool authorize(uint8_t address, uint8_t nozzle, FuelMode mode, uint32_t quantity, uint16_t price) {
+        return rs422SendTransaction(address, nozzle, mode, quantity, price);
+    }
+    static bool readLiveVolume(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendLitersMonitor(address, callback, context);
+    }
+    static bool readLiveAmount(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendRevenueStatus(address, callback, context);
+    }
+    static bool readFinalTotals(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendTransactionUpdate(address, callback, context);
+    }
+    static bool readTotalizer(uint8_t address, uint8_t nozzle, Rs422Callback callback, void* context) {
+        return rs422SendTotalCounter(address, nozzle, callback, context);
+    }
+    static bool nozzleOff(uint8_t address) { return rs422SendNozzleOff(address); }
+    static bool stop(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendStop(address, callback, context);
+    }
+    static bool pause(uint8_t address, Rs422Callback callback, void* context) {
+        return rs422SendPause(address, callback, context);
+    }
+    static bool resume(uint8_t address) { return rs422SendResume(address); }
+};
+
+#endif
\ No newline at end of file
@@ -8,6 +8,17 @@
 #define SCREEN_HEIGHT 64        // Высота экрана в пикселях
 #define OLED_RESET    -1        // Пин сброса дисплея (-1, если не используется)
 #define SCREEN_ADDRESS 0x3C     // I2C-адрес дисплея
+#define DISPLAY_BUFFER_ROWS 8   // Строк тайлов в буфере дисплея: 8 — кадр целиком (1024 байт ОЗУ), 2 или 1 — по страницам (256/128 байт)
+#define DISPLAY_MAX_LINES 4     // Строк текста на экране
+#define DISPLAY_LINE_SIZE 24    // Буфер строки текста (символы с завершающим нулём)
+#define DISPLAY_TEXT_SIZE 32    // Наибольший постоянный текст экрана с завершающим нулём (DisplayText)
+#define DISPLAY_REFRESH_INTERVAL 10000 // Полная передача кадра не реже (мс): страховка от совпадения сумм тайлов
+#define DISPLAY_FRAME_INTERVAL 100 // Период вывода модели экрана (мс): 100 — не больше 10 кадров в секунду
+#define DISPLAY_TOAST_DURATION 1000 // Время показа всплывающего предупреждения (мс)
+#define DISPLAY_I2C_CLOCK 400000 // Частота I2C дисплея (Гц): 400000 — fast mode, 100000 — стандартная
+#define DISPLAY_ASYNC_FLUSH 1   // 1 — кадр передаётся своим драйвером TWI (twi.h) из главного цикла без ожидания; 0 — через Wire с ожиданием
+#define DISPLAY_BYTE_BUFFER 32  // Буфер одной транзакции команд U8g2 при DISPLAY_ASYNC_FLUSH (байт)
+#define TWI_HEAD_SIZE 8         // Заголовок транзакции TWI, копируемый драйвером (байт)
 
 // Параметры клавиатуры
 #define KEYPAD_ROW_COUNT 5      // Количество строк клавиатуры
@@ -15,19 +26,60 @@
 const byte KEYPAD_ROWS[KEYPAD_ROW_COUNT] = {22, 23, 24, 25, 26}; // Пины строк
 const byte KEYPAD_COLS[KEYPAD_COL_COUNT] = {27, 28, 29, 30};     // Пины столбцов
 #define KEY_DEBOUNCE_MS 100
-#define MAX_ERROR_COUNT 10 // Увеличено для большей надёжности
 
 // Параметры интерфейса RS-422
-#define RS422_BAUD_RATE 9600    // Скорость передачи данных (бод)
+#define RS422_BAUD_RATE 9600    // Скорость по умолчанию, если ни один пост не ответил при подборе (бод)
+const uint32_t RS422_BAUD_RATES[] = {38400, 19200, 9600}; // Проверяемые скорости, от быстрой к медленной
+#define BAUD_PROBE_TIMEOUT 100  // Ожидание ответа S при подборе скорости (мс)
+#define BAUD_FALLBACK_ERRORS 8  // Ошибок CRC подряд до перехода на более низкую скорость
+#define RS422_RX_BUFFER_SIZE 64 // Размер кольцевого буфера приёма (байт, степень двойки)
+#define RS422_TX_BUFFER_SIZE 64 // Размер очереди передачи (байт, степень двойки)
+#define RS422_URGENT_RESERVE 2  // Места очереди только для срочных N/B и прерванного ими опроса
+#define RS422_QUEUE_SIZE (POST_COUNT + 4 + RS422_URGENT_RESERVE) // Глубина очереди запросов к ТРК
+#define BUS_PRIORITY_BURST 4    // Запросов постов с наливом подряд, после чего очередь уступает остальным
+#define BUS_URGENT_DEADLINE 40  // Допустимое время от нажатия стоп/пауза до выхода N/B в линию (мс)
+#define BUS_REPORT_INTERVAL 10000 // Период вывода статистики шины в отладочный порт (мс)
+#define UART_TICK_SHIFT 6       // Метка времени байта: micros() >> 6 (тик 64 мкс)
 
 // Таймауты и задержки
 #define RESPONSE_TIMEOUT 3000   // Максимальное время ожидания ответа ТРК (мс)
-#define INTERBYTE_TIMEOUT 3     // Таймаут между байтами в ответе (мс)
-#define DELAY_AFTER_RESPONSE 3  // Задержка после получения ответа (мс)
+#define ACK_TIMEOUT 200         // Ожидание подтверждения управляющих команд N/B/G/V/M (мс)
+#define INTERBYTE_CHARS 3       // Пауза конца кадра в символах на текущей скорости (3 символа при 9600 — около 3 мс)
 #define DISPLAY_WELCOME_DURATION 500 // Длительность отображения приветствия (мс)
 #define EDIT_TIMEOUT 10000      // Таймаут редактирования цены (мс)
 #define VIEW_TIMEOUT 2000       // Таймаут просмотра цены (мс)
 #define TRANSITION_TIMEOUT 2000 // Таймаут переходных состояний (мс)
+#define PAUSE_CONFIRM_TIMEOUT 1000 // Ожидание статуса паузы после команды B; до него B повторяется (мс)
+#define STOP_CONFIRM_TIMEOUT 1000 // Ожидание выхода ТРК из разрешения налива после команды N; до него N повторяется (мс)
+
+// Адаптивные таймауты ответа по измеренному времени обмена (как RTO в TCP)
+#define RTT_TIMEOUT_MIN 20      // Нижняя граница таймаута ответа (мс)
+#define RTT_TIMEOUT_MAX RESPONSE_TIMEOUT // Верхняя граница; действует, пока пост не ответил ни разу (мс)
+#define RTT_GRANULARITY 8       // Нижняя граница 4·rttvar: запас таймаута над srtt при ровных ответах (мс)
+#define RTT_MAX_BACKOFF 3       // Удвоений таймаута подряд после потерянных ответов
+
+// Повторы запросов на шине: бюджет по командам и пауза перед повтором
+#define RETRY_BUDGET_STATUS 4           // S
+#define RETRY_BUDGET_MONITOR 2          // L, R (следующий опрос всё равно скоро)
+#define RETRY_BUDGET_TRANSACTION_END 5  // T
+#define RETRY_BUDGET_TOTAL 3            // C
+#define RETRY_BUDGET_CONTROL 1          // N, B, G (только при искажённом ответе)
+#define RETRY_BACKOFF_BASE 25           // Пауза перед первым повтором (мс), далее удваивается
+#define RETRY_BACKOFF_MAX 800           // Предел паузы перед повтором (мс)
+
+// Восстановление связи с постом
+#define RECONNECT_PROBE_MIN 20  // Первый пробный опрос после потери связи (мс), далее период удваивается
+#define RECONNECT_PROBE_MAX 2000 // Предел периода пробных опросов (мс)
+
+// Политика опроса ТРК (S/L/R)
+#define POLL_IDLE_INTERVAL_MIN 50    // Период опроса S в ожидании сразу после события (мс)
+#define POLL_IDLE_INTERVAL_MAX 1000  // Период «пульса» в ожидании после затухания (мс)
+#define POLL_QUIET_POLLS 10          // Ответов без изменений до удвоения периода
+#define POLL_DISPENSE_INTERVAL 0     // Период опроса при наливе (0 — как позволяет шина)
+#define POLL_DISPENSE_WEIGHT_S 1     // Доля S при наливе
+#define POLL_DISPENSE_WEIGHT_L 3     // Доля L при наливе
+#define POLL_DISPENSE_WEIGHT_R 3     // Доля R при наливе
+#define POLL_PAUSED_INTERVAL 250     // Период опроса S на паузе (мс)
 
 // Параметры ввода цены
 #define PRICE_FORMAT_LENGTH 7   // Максимальная длина ввода цены (символы)
@@ -37,21 +89,33 @@ const byte KEYPAD_COLS[KEYPAD_COL_COUNT] = {27, 28, 29, 30};     // Пины с
 // Длины ответов протокола
 #define STATUS_RESPONSE_LENGTH 7            // Длина ответа на команду статуса
 #define MONITOR_RESPONSE_LENGTH 15          // Длина ответа на команды L и R
-#define TRANSACTION_END_RESPONSE_LENGTH 27  // Длина ответа на команду T
+#define TRANSACTION_END_RESPONSE_LENGTH 27  // Длина ответа на команду T (с флагом 'u')
+#define TRANSACTION_END_SHORT_RESPONSE_LENGTH 18 // Длина ответа на команду T без флага 'u'
 #define TOTAL_COUNTER_RESPONSE_LENGTH 16    // Длина ответа на команду C
 
 // Прочие параметры
-#define MAX_ERROR_COUNT 5       // Максимальное число ошибок перед TRK Error
+#define MAX_ERROR_COUNT 5       // Нераспознанных статусов подряд перед TRK Error
 #define KEY_DEBOUNCE_MS 200     // Антидребезг клавиш (мс)
 #define NOZZLE_COUNT 6          // Максимальное число рукавов
-#define POST_ADDRESS 1          // Адрес поста (1-32)
+#define POST_COUNT 1            // Число постов на шине (1-32)
+const byte POST_ADDRESSES[POST_COUNT] = {1}; // Адреса постов (1-32)
+#define FSM_HOT_STATE_BUDGET 44 // Байт горячего состояния FSM на пост (без таблицы рукавов)
+
+// Протокол ТРК (pump.h)
+#define PUMP_DRIVER_CENSTAR 0   // GasKitLink по RS422
+#define PUMP_DRIVER_MOCK 1      // Имитатор ТРК без линии (стенд)
+#define PUMP_DRIVER PUMP_DRIVER_CENSTAR // Выбранный драйвер
+#define MOCK_REPLY_DELAY 20     // Задержка ответа имитатора (мс)
+#define MOCK_FLOW_RATE 67       // Скорость налива имитатора (0.01 л/с)
 
 // Параметры логирования
 #define LOG_LEVEL_DEBUG 0       // Уровень отладочных сообщений
 #define LOG_LEVEL_ERROR 1       // Уровень сообщений об ошибках
 #define LOG_LEVEL LOG_LEVEL_DEBUG // Текущий уровень логирования
+#define BENCHMARK_ON_START 0    // 1 — замер тактов разбора и вывода чисел при запуске (bench.h)
 
 // Параметры кадров протокола
 #define MAX_FRAME_PAYLOAD 16    // Максимальная длина полезной нагрузки кадра
+#define MAX_FRAME_LENGTH 32     // Максимальная длина принимаемого кадра
 
 #endif
\ No newline at end of file
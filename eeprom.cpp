@@ -1,42 +1,68 @@
 #include "eeprom.h"
 #include <EEPROM.h>
+#include "config.h"
 
 #define EEPROM_PRICE_ADDR 0
-#define EEPROM_LITERS_ADDR 4
-#define EEPROM_PRICE_TOTAL_ADDR 8
-#define EEPROM_STATE_ADDR 12
-#define EEPROM_MODE_ADDR 14
-#define EEPROM_MODE_SELECTED_ADDR 15
-
-void writePriceToEEPROM(uint16_t price) {
-    EEPROM.put(EEPROM_PRICE_ADDR, price);
+// Состояние транзакции хранится в отдельном слоте для каждого поста
+#define EEPROM_POST_BASE 4
+#define EEPROM_POST_SLOT_SIZE 12
+#define EEPROM_LITERS_ADDR 0
+#define EEPROM_PRICE_TOTAL_ADDR 4
+#define EEPROM_STATE_ADDR 8
+#define EEPROM_NOZZLE_ADDR 9
+#define EEPROM_MODE_ADDR 10
+#define EEPROM_MODE_SELECTED_ADDR 11
+
+// Цены рукавов: таблица после слотов всех 32 постов
+#define EEPROM_NOZZLE_PRICE_BASE (EEPROM_POST_BASE + 32 * EEPROM_POST_SLOT_SIZE)
+
+static int postSlot(uint8_t post) {
+    return EEPROM_POST_BASE + post * EEPROM_POST_SLOT_SIZE;
+}
+
+static int nozzlePriceAddr(uint8_t post, uint8_t nozzle) {
+    return EEPROM_NOZZLE_PRICE_BASE + (post * NOZZLE_COUNT + (nozzle - 1)) * sizeof(uint16_t);
+}
+
+void writePriceToEEPROM(uint8_t post, uint8_t nozzle, uint16_t price) {
+    EEPROM.put(nozzlePriceAddr(post, nozzle), price);
 }
 
-uint16_t readPriceFromEEPROM() {
+uint16_t readPriceFromEEPROM(uint8_t post, uint8_t nozzle) {
     uint16_t price;
-    EEPROM.get(EEPROM_PRICE_ADDR, price);
+    EEPROM.get(nozzlePriceAddr(post, nozzle), price);
+    if (price == 0xFFFF) {
+        // Цена рукава не задавалась: первый рукав берёт прежнюю общую цену
+        if (nozzle != 1) return 0;
+        EEPROM.get(EEPROM_PRICE_ADDR, price);
+    }
     return price;
 }
 
-void saveTransactionState(uint32_t liters, uint32_t price, FSMState state, FuelMode mode, bool modeSelected) {
-    EEPROM.put(EEPROM_LITERS_ADDR, liters);
-    EEPROM.put(EEPROM_PRICE_TOTAL_ADDR, price);
-    EEPROM.put(EEPROM_STATE_ADDR, (uint8_t)state);
-    EEPROM.put(EEPROM_MODE_ADDR, (uint8_t)mode);
-    EEPROM.put(EEPROM_MODE_SELECTED_ADDR, (uint8_t)modeSelected);
+void saveTransactionState(uint8_t post, uint8_t nozzle, uint32_t liters, uint32_t price, FSMState state, FuelMode mode, bool modeSelected) {
+    int slot = postSlot(post);
+    EEPROM.put(slot + EEPROM_LITERS_ADDR, liters);
+    EEPROM.put(slot + EEPROM_PRICE_TOTAL_ADDR, price);
+    EEPROM.put(slot + EEPROM_STATE_ADDR, (uint8_t)state);
+    EEPROM.put(slot + EEPROM_NOZZLE_ADDR, nozzle);
+    EEPROM.put(slot + EEPROM_MODE_ADDR, (uint8_t)mode);
+    EEPROM.put(slot + EEPROM_MODE_SELECTED_ADDR, (uint8_t)modeSelected);
 }
 
-bool restoreTransactionState(uint32_t* liters, uint32_t* price, FSMState* state, FuelMode* mode, bool* modeSelected) {
+bool restoreTransactionState(uint8_t post, uint8_t* nozzle, uint32_t* liters, uint32_t* price, FSMState* state, FuelMode* mode, bool* modeSelected) {
+    int slot = postSlot(post);
     uint8_t savedState;
-    EEPROM.get(EEPROM_LITERS_ADDR, *liters);
-    EEPROM.get(EEPROM_PRICE_TOTAL_ADDR, *price);
-    EEPROM.get(EEPROM_STATE_ADDR, savedState);
+    EEPROM.get(slot + EEPROM_LITERS_ADDR, *liters);
+    EEPROM.get(slot + EEPROM_PRICE_TOTAL_ADDR, *price);
+    EEPROM.get(slot + EEPROM_STATE_ADDR, savedState);
     *state = (FSMState)savedState;
+    EEPROM.get(slot + EEPROM_NOZZLE_ADDR, *nozzle);
+    if (*nozzle > NOZZLE_COUNT) *nozzle = 0;
     uint8_t savedMode;
-    EEPROM.get(EEPROM_MODE_ADDR, savedMode);
+    EEPROM.get(slot + EEPROM_MODE_ADDR, savedMode);
     *mode = (FuelMode)savedMode;
     uint8_t savedModeSelected;
-    EEPROM.get(EEPROM_MODE_SELECTED_ADDR, savedModeSelected);
+    EEPROM.get(slot + EEPROM_MODE_SELECTED_ADDR, savedModeSelected);
     *modeSelected = (bool)savedModeSelected;
     return (*liters != 0xFFFFFFFF && *price != 0xFFFFFFFF && savedState != 0xFF);
 }
\ No newline at end of file
@@ -4,9 +4,9 @@
 #include <Arduino.h>
 #include "fsm.h"
 
-void writePriceToEEPROM(uint16_t price);
-uint16_t readPriceFromEEPROM();
-void saveTransactionState(uint32_t liters, uint32_t price, FSMState state, FuelMode mode, bool modeSelected);
-bool restoreTransactionState(uint32_t* liters, uint32_t* price, FSMState* state, FuelMode* mode, bool* modeSelected);
+void writePriceToEEPROM(uint8_t post, uint8_t nozzle, uint16_t price);
+uint16_t readPriceFromEEPROM(uint8_t post, uint8_t nozzle);
+void saveTransactionState(uint8_t post, uint8_t nozzle, uint32_t liters, uint32_t price, FSMState state, FuelMode mode, bool modeSelected);
+bool restoreTransactionState(uint8_t post, uint8_t* nozzle, uint32_t* liters, uint32_t* price, FSMState* state, FuelMode* mode, bool* modeSelected);
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "frame.h"
 #include "crc.h"
 #include "config.h"
+#include "message.h"
 
 void assembleFrame(const byte* slaveAddress, char command, const byte* payload, int payloadLength, byte* frameBuffer, int* frameLength) {
     if (payloadLength > MAX_FRAME_PAYLOAD) return;
@@ -15,4 +16,140 @@ void assembleFrame(const byte* slaveAddress, char command, const byte* payload,
     byte crc = calculateCRC(frameBuffer, index);
     frameBuffer[index++] = crc;
     *frameLength = index;
+}
+
+// Кадры команд без данных и команды C для всех адресов шины собраны при компиляции и лежат во флеш-памяти:
+// STX, адрес (0x00, 1-32), команда, [цифра рукава], CRC (XOR всех байт после STX)
+#define BUS_ADDRESS_COUNT 32
+#define FIXED_COMMAND_COUNT 7
+#define FIXED_FRAME_LENGTH StatusRequest::length
+#define COUNTER_NOZZLE_COUNT 9
+#define COUNTER_FRAME_LENGTH TotalCounterRequest::length
+
+#define FIXED_FRAME(a, c) {0x02, 0x00, (a), (c), (uint8_t)((a) ^ (c))}
+#define FIXED_ROW(a) {FIXED_FRAME(a, 'S'), FIXED_FRAME(a, 'T'), FIXED_FRAME(a, 'N'), FIXED_FRAME(a, 'L'), \
+                      FIXED_FRAME(a, 'R'), FIXED_FRAME(a, 'B'), FIXED_FRAME(a, 'G')},
+#define COUNTER_FRAME(a, n) {0x02, 0x00, (a), 'C', '0' + (n), (uint8_t)((a) ^ 'C' ^ ('0' + (n)))}
+#define COUNTER_ROW(a) {COUNTER_FRAME(a, 1), COUNTER_FRAME(a, 2), COUNTER_FRAME(a, 3), COUNTER_FRAME(a, 4), \
+                        COUNTER_FRAME(a, 5), COUNTER_FRAME(a, 6), COUNTER_FRAME(a, 7), COUNTER_FRAME(a, 8), \
+                        COUNTER_FRAME(a, 9)},
+#define ROWS_8(row, base) row(base + 1) row(base + 2) row(base + 3) row(base + 4) \
+                          row(base + 5) row(base + 6) row(base + 7) row(base + 8)
+#define ROWS_32(row) ROWS_8(row, 0) ROWS_8(row, 8) ROWS_8(row, 16) ROWS_8(row, 24)
+
+static const uint8_t fixedFrames[BUS_ADDRESS_COUNT][FIXED_COMMAND_COUNT][FIXED_FRAME_LENGTH] PROGMEM = {
+    ROWS_32(FIXED_ROW)
+};
+
+static const uint8_t counterFrames[BUS_ADDRESS_COUNT][COUNTER_NOZZLE_COUNT][COUNTER_FRAME_LENGTH] PROGMEM = {
+    ROWS_32(COUNTER_ROW)
+};
+
+// Порядок команд в строке fixedFrames
+static int8_t fixedCommandIndex(char command) {
+    switch (command) {
+        case 'S': return 0;
+        case 'T': return 1;
+        case 'N': return 2;
+        case 'L': return 3;
+        case 'R': return 4;
+        case 'B': return 5;
+        case 'G': return 6;
+        default: return -1;
+    }
+}
+
+const uint8_t* fixedFrame(uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength, uint8_t* length) {
+    if (address < 1 || address > BUS_ADDRESS_COUNT) return nullptr;
+    if (payloadLength == 0) {
+        int8_t index = fixedCommandIndex(command);
+        if (index < 0) return nullptr;
+        *length = FIXED_FRAME_LENGTH;
+        return fixedFrames[address - 1][index];
+    }
+    if (command == 'C' && payloadLength == 1 && payload[0] >= '1' && payload[0] <= '0' + COUNTER_NOZZLE_COUNT) {
+        *length = COUNTER_FRAME_LENGTH;
+        return counterFrames[address - 1][payload[0] - '1'];
+    }
+    return nullptr;
+}
+
+enum {
+    FRAME_STATE_STX,
+    FRAME_STATE_ADDR_HI,
+    FRAME_STATE_ADDR_LO,
+    FRAME_STATE_COMMAND,
+    FRAME_STATE_BODY
+};
+
+static FrameFeedResult resync(FrameDecoder* dec, uint8_t data) {
+    dec->state = FRAME_STATE_STX;
+    // Отвергнутый байт сам может быть началом кадра
+    if (data == 0x02) frameDecoderFeed(dec, data);
+    return FRAME_FEED_RESYNC;
+}
+
+void frameDecoderReset(FrameDecoder* dec, uint8_t address) {
+    dec->state = FRAME_STATE_STX;
+    dec->address = address;
+    dec->count = 0;
+    dec->expected = 0;
+    dec->crc = 0;
+}
+
+FrameFeedResult frameDecoderFeed(FrameDecoder* dec, uint8_t data) {
+    switch (dec->state) {
+        case FRAME_STATE_STX:
+            if (data != 0x02) return FRAME_FEED_PENDING;
+            dec->buffer[0] = data;
+            dec->count = 1;
+            dec->expected = 0;
+            dec->crc = 0;
+            dec->state = FRAME_STATE_ADDR_HI;
+            return FRAME_FEED_PENDING;
+        case FRAME_STATE_ADDR_HI:
+            if (data != 0x00) return resync(dec, data);
+            dec->state = FRAME_STATE_ADDR_LO;
+            break;
+        case FRAME_STATE_ADDR_LO:
+            if (dec->address != 0 && data != dec->address) return resync(dec, data);
+            dec->state = FRAME_STATE_COMMAND;
+            break;
+        case FRAME_STATE_COMMAND:
+            if (data < 'A' || data > 'Z') return resync(dec, data);
+            dec->state = FRAME_STATE_BODY;
+            break;
+        default:
+            break;
+    }
+
+    dec->buffer[dec->count++] = data;
+    dec->crc ^= data;
+    if (dec->state != FRAME_STATE_BODY || dec->count < 5) return FRAME_FEED_PENDING;
+
+    if (dec->expected == 0) {
+        dec->expected = messageReplyLength(dec->buffer, dec->count);
+    }
+    if (dec->expected != 0 && dec->count >= dec->expected) {
+        dec->state = FRAME_STATE_STX;
+        // XOR CRC кадра вместе с байтом CRC даёт ноль
+        return dec->crc == 0 ? FRAME_FEED_COMPLETE : FRAME_FEED_BAD_CRC;
+    }
+    if (dec->count >= MAX_FRAME_LENGTH) {
+        dec->state = FRAME_STATE_STX;
+        return FRAME_FEED_RESYNC;
+    }
+    return FRAME_FEED_PENDING;
+}
+
+FrameFeedResult frameDecoderFinish(FrameDecoder* dec) {
+    if (dec->state == FRAME_STATE_STX) return FRAME_FEED_PENDING;
+    bool gapTerminated = dec->state == FRAME_STATE_BODY && dec->expected == 0 && dec->count >= 5;
+    dec->state = FRAME_STATE_STX;
+    if (!gapTerminated) return FRAME_FEED_RESYNC;
+    return dec->crc == 0 ? FRAME_FEED_COMPLETE : FRAME_FEED_BAD_CRC;
+}
+
+bool frameDecoderBusy(const FrameDecoder* dec) {
+    return dec->state != FRAME_STATE_STX;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define FRAME_H
 
 #include <Arduino.h>
+#include "config.h"
 
 /**
  * Assembles a GasKitLink v1.2 frame.
@@ -14,4 +15,69 @@
  */
 void assembleFrame(const byte* slaveAddress, char command, const byte* payload, int payloadLength, byte* frameBuffer, int* frameLength);
 
+/**
+ * Looks up the precomputed frame of a fixed command: S, T, N, L, R, B, G
+ * without payload, or C with a nozzle digit, for any bus address.
+ * The frame is in flash; send it with uartWriteP.
+ * @param address Post address (1-32).
+ * @param command Command code.
+ * @param payload Payload data.
+ * @param payloadLength Length of payload.
+ * @param length Output length of frame.
+ * @return PROGMEM pointer to the frame, or nullptr if the frame has to be assembled.
+ */
+const uint8_t* fixedFrame(uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength, uint8_t* length);
+
+typedef enum {
+    FRAME_FEED_PENDING,   // Кадр ещё собирается (или байт пропущен до STX)
+    FRAME_FEED_COMPLETE,  // Кадр собран, CRC верна
+    FRAME_FEED_BAD_CRC,   // Кадр собран, CRC неверна
+    FRAME_FEED_RESYNC     // Мусор или чужой адрес, поиск следующего STX
+} FrameFeedResult;
+
+/**
+ * Byte-at-a-time GasKitLink frame decoder.
+ * Syncs on STX, checks the slave address, derives the frame length from the
+ * command byte (and the 'u' flag for 'T') and keeps the XOR CRC running, so a
+ * frame is accepted as soon as its last byte arrives.
+ */
+struct FrameDecoder {
+    uint8_t state;
+    uint8_t address;                     // Ожидаемый младший байт адреса (0 — любой)
+    uint8_t count;                       // Принято байт текущего кадра
+    uint8_t expected;                    // Полная длина кадра (0 — ещё неизвестна)
+    uint8_t crc;                         // XOR всех байт после STX
+    uint8_t buffer[MAX_FRAME_LENGTH];
+};
+
+/**
+ * Resets the decoder and waits for the next STX.
+ * @param dec Decoder.
+ * @param address Low address byte to accept (0 accepts any).
+ */
+void frameDecoderReset(FrameDecoder* dec, uint8_t address);
+
+/**
+ * Feeds one received byte into the decoder.
+ * @param dec Decoder.
+ * @param data Received byte.
+ * @return Decoding result; on FRAME_FEED_COMPLETE the frame is in dec->buffer.
+ */
+FrameFeedResult frameDecoderFeed(FrameDecoder* dec, uint8_t data);
+
+/**
+ * Ends the current frame on a line gap. Frames of commands with no known reply
+ * length are accepted here if their CRC matches.
+ * @param dec Decoder.
+ * @return FRAME_FEED_COMPLETE/FRAME_FEED_BAD_CRC for a gap-terminated frame,
+ *         FRAME_FEED_RESYNC if a known-length frame was cut short,
+ *         FRAME_FEED_PENDING if no frame was in progress.
+ */
+FrameFeedResult frameDecoderFinish(FrameDecoder* dec);
+
+/**
+ * Returns true while a frame is partially received.
+ */
+bool frameDecoderBusy(const FrameDecoder* dec);
+
 #endif
\ No newline at end of file
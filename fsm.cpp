@@ -2,271 +2,708 @@
 #include "config.h"
 #include "eeprom.h"
 #include "oled.h"
-#include "rs422.h"
+#include "screen.h"
+#include "pump.h"
 #include "crc.h"
+#include "utils.h"
 
-/* Вспомогательные функции форматирования */
-static void formatLiters(uint32_t dl, char* dst, size_t dstLen) {
-    uint32_t intPart = dl / 100;
-    uint32_t fracPart = dl % 100;
-    snprintf(dst, dstLen, "%lu.%02lu", (unsigned long)intPart, (unsigned long)fracPart);
+// Ответы читаются через представления выбранного драйвера ТРК
+typedef PumpDriver::ReplyView ReplyView;
+typedef PumpDriver::StatusReply StatusReply;
+typedef PumpDriver::MonitorReply MonitorReply;
+typedef PumpDriver::TransactionEndReply TransactionEndReply;
+typedef PumpDriver::TotalCounterReply TotalCounterReply;
+
+/* Рукава: в ответах ТРК номер рукава — цифра '1'..'9', '0' — рукав не снят */
+static uint8_t nozzleFromDigit(uint8_t digit) {
+    uint8_t nozzle = digit - '0';
+    return (nozzle >= 1 && nozzle <= NOZZLE_COUNT) ? nozzle : 0;
+}
+
+// Рукав текущего налива, вне налива — выбранный оператором
+static NozzleState* currentNozzle(FSMContext* ctx) {
+    uint8_t nozzle = ctx->activeNozzle ? ctx->activeNozzle : ctx->selectedNozzle;
+    return &ctx->nozzles[nozzle - 1];
+}
+
+static const NozzleState* currentNozzle(const FSMContext* ctx) {
+    return currentNozzle(const_cast<FSMContext*>(ctx));
+}
+
+/* Статус из ответа S: код и признак снятого рукава (любой номер) */
+static bool statusIs(StatusReply reply, char code, bool nozzleUp) {
+    return reply.code() == code && reply.nozzleUp() == nozzleUp;
+}
+
+// Запоминает рукав, о котором сообщает статус ТРК
+static void trackNozzle(FSMContext* ctx, StatusReply reply) {
+    uint8_t nozzle = nozzleFromDigit(reply.nozzleDigit());
+    if (nozzle) {
+        ctx->activeNozzle = nozzle;
+    } else if (reply.code() == '1') {
+        ctx->activeNozzle = 0;
+    }
+}
+
+/* Дисплей и клавиатура принадлежат одному посту; остальные посты работают без вывода */
+static const FSMContext* displayOwner = nullptr;
+
+/* Состояние ввода с клавиатуры: одно на все посты, принадлежит посту дисплея */
+struct FSMUiState {
+    char priceInput[PRICE_FORMAT_LENGTH + 1];
+    uint16_t lastKeyTime;
+};
+static FSMUiState ui;
+
+/* Метки времени поста — младшие 16 бит millis(); разность берётся по модулю 2^16 */
+static uint16_t elapsed(unsigned long now, uint16_t stamp) {
+    return (uint16_t)now - stamp;
+}
+
+/* Экран меняют только через модель компоновщика (screen.h); на дисплей она уходит с постоянной частотой */
+static void showMessage(const FSMContext* ctx, const char* msg) {
+    if (ctx == displayOwner) {
+        screenShowMessage(msg);
+    }
+}
+
+static void showText(const FSMContext* ctx, DisplayText text) {
+    if (ctx == displayOwner) {
+        screenShowText(text);
+    }
+}
+
+// Предупреждение поверх экрана на DISPLAY_TOAST_DURATION: налив под ним продолжает обновляться
+static void showToast(const FSMContext* ctx, DisplayText text) {
+    if (ctx == displayOwner) {
+        screenToast(text);
+    }
 }
 
-static void displayFuelMode(FuelMode mode) {
-    switch (mode) {
-        case FUEL_BY_VOLUME:    displayMessage("Mode: Volume");     break;
-        case FUEL_BY_PRICE:     displayMessage("Mode: Price");      break;
-        case FUEL_BY_FULL_TANK: displayMessage("Mode: Full Tank");  break;
+static void displayFuelMode(const FSMContext* ctx) {
+    switch (ctx->fuelMode) {
+        case FUEL_BY_VOLUME:    showText(ctx, TEXT_MODE_VOLUME);     break;
+        case FUEL_BY_PRICE:     showText(ctx, TEXT_MODE_PRICE);      break;
+        case FUEL_BY_FULL_TANK: showText(ctx, TEXT_MODE_FULL_TANK);  break;
     }
 }
 
-static void displayTransaction(uint32_t liters, uint32_t price, const char* status, bool priceScaled) {
-    char litersBuf[12];
-    formatLiters(liters, litersBuf, sizeof(litersBuf));
-    char displayStr[48];
-    uint32_t displayPrice = priceScaled ? price * 10 : price;
-    snprintf(displayStr, sizeof(displayStr), "%s\nL: %s\nP: %lu", status, litersBuf, (unsigned long)displayPrice);
-    displayMessage(displayStr);
+// Экран ожидания: выбранный режим налива или приглашение его выбрать
+static void displayIdle(const FSMContext* ctx) {
+    if (ctx->modeSelected) {
+        displayFuelMode(ctx);
+    } else {
+        showText(ctx, TEXT_SELECT_MODE);
+    }
+}
+
+static void displayTransaction(const FSMContext* ctx, uint32_t liters, uint32_t price, DisplayText status) {
+    if (ctx != displayOwner) return;
+    uint32_t displayPrice = currentNozzle(ctx)->price > 9999 ? price * 10 : price;
+    screenShowTransaction(status, liters, displayPrice);
+}
+
+static void displayNozzlePrice(const FSMContext* ctx) {
+    char priceStr[24];
+    char* end = appendText(priceStr, "N");
+    end = formatUnsigned(end, ctx->selectedNozzle);
+    end = appendText(end, " Price: ");
+    formatUnsigned(end, ctx->nozzles[ctx->selectedNozzle - 1].price);
+    showMessage(ctx, priceStr);
+}
+
+// Клавиша D: следующий рукав поста для просмотра и правки цены, просмотра счётчика
+static void selectNextNozzle(FSMContext* ctx) {
+    ctx->selectedNozzle = ctx->selectedNozzle % NOZZLE_COUNT + 1;
+}
+
+// Смена состояния с действиями входа и выхода (таблица stateHooks ниже)
+static void enterState(FSMContext* ctx, FSMState next);
+
+/* Связь с постом потеряна или ТРК в неизвестном состоянии: режим восстановления.
+   Пробные S идут сначала часто, затем период удваивается до RECONNECT_PROBE_MAX */
+struct RecoveryStats {
+    uint16_t recoveries;
+    uint32_t lastOutage;        // От потери связи до рабочего состояния (мс)
+    uint32_t maxOutage;
+    uint16_t lastResync;        // От первого ответа до рабочего состояния (мс)
+    uint16_t maxResync;
+};
+static RecoveryStats recovery;
+
+static void enterError(FSMContext* ctx, DisplayText text) {
+    unsigned long currentMillis = millis();
+    if (ctx->state != FSM_STATE_ERROR) {
+        ctx->offlineSince = currentMillis;
+        ctx->probeStep = 0;
+    }
+    ctx->resyncStatus = 0;
+    enterState(ctx, FSM_STATE_ERROR);
+    showText(ctx, text);
+}
+
+// Пост снова в рабочем состоянии: время восстановления в статистику
+static void recordRecovery(FSMContext* ctx, uint16_t resyncMs) {
+    uint32_t outage = millis() - ctx->offlineSince;
+    recovery.recoveries++;
+    recovery.lastOutage = outage;
+    recovery.lastResync = resyncMs;
+    if (outage > recovery.maxOutage) recovery.maxOutage = outage;
+    if (resyncMs > recovery.maxResync) recovery.maxResync = resyncMs;
+    Serial.print("Post ");
+    Serial.print(ctx->address);
+    Serial.print(" recovered: outage ");
+    Serial.print(outage);
+    Serial.print(" ms, resync ");
+    Serial.print(resyncMs);
+    Serial.println(" ms");
 }
 
 /* Обработка ответов ТРК */
-static bool handleResponse(uint8_t* buffer, int length, int expected, FSMContext* ctx) {
+static bool statusRecognised(StatusReply reply);
+
+// Повторы уже сделаны на шине по политике команды (retry.h): неудача здесь — пост не отвечает
+static bool handleResponse(const uint8_t* buffer, int length, int expected, FSMContext* ctx) {
+    ctx->waitingForResponse = false;
     if (length >= expected) {
-        ctx->waitingForResponse = false;
-        ctx->errorCount = 0;
+        // errorCount считает нераспознанные статусы подряд
+        if (ReplyView(buffer).command() != 'S' || statusRecognised(StatusReply(buffer))) ctx->errorCount = 0;
         return true;
     }
-    ctx->waitingForResponse = false;
-    ctx->errorCount++;
-    if (ctx->errorCount >= MAX_ERROR_COUNT) {
-        ctx->state = FSM_STATE_ERROR;
-        ctx->stateEntryTime = millis();
-        displayMessage("Pump Error");
-    }
+    enterError(ctx, length < 0 ? TEXT_INVALID_RESPONSE : TEXT_PUMP_ERROR);
     return false;
 }
 
-/* Таблица статусов ТРК */
-struct StatusAction {
-    char code[2];
-    FSMState nextState;
-    bool resetErrorCount;
-    const char* warning;
+/* Запросы к ТРК: ответ приходит в колбэк состояния, отправившего запрос */
+static void onCheckStatusReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onErrorReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onIdleReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onTransactionReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onTransactionPausedReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onTransactionEndReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+static void onTotalCounterReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength);
+
+/* Доставка срочных команд оператора (стоп, пауза) */
+static void onControlDelivered(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = (FSMContext*)context;
+    if (status != RS422_RX_READY) {
+        enterError(ctx, TEXT_STOP_PAUSE_FAILED);
+    }
+}
+
+static void requestStatus(FSMContext* ctx, Rs422Callback callback) {
+    ctx->waitingForResponse = PumpDriver::pollStatus(ctx->address, callback, ctx);
+}
+
+static void requestTransactionUpdate(FSMContext* ctx) {
+    ctx->transactionDataReceived = false;
+    ctx->waitingForResponse = PumpDriver::readFinalTotals(ctx->address, onTransactionEndReply, ctx);
+}
+
+// Снятие разрешения налива: N, не вставшая в очередь шины, повторяется в updateFSM
+static void requestNozzleOff(FSMContext* ctx) {
+    ctx->nozzleOffPending = !PumpDriver::nozzleOff(ctx->address);
+}
+
+/* Ответ, пришедший после смены состояния, только снимает ожидание */
+static FSMContext* replyContext(void* context, FSMState expectedState) {
+    FSMContext* ctx = (FSMContext*)context;
+    if (ctx->state != expectedState) {
+        ctx->waitingForResponse = false;
+        return nullptr;
+    }
+    return ctx;
+}
+
+/* Переходы по статусу ТРК: таблица (состояние, код статуса) -> действие */
+
+// Код статуса — цифра 1-9 и признак снятого рукава ('0' — рукав не снят); индекс (цифра - 1) * 2 + признак
+#define STATUS_CODE_COUNT 18
+
+static constexpr uint8_t statusIndex(char code, bool nozzleUp) {
+    return (code - '1') * 2 + (nozzleUp ? 1 : 0);
+}
+
+static int8_t statusIndex(StatusReply reply) {
+    uint8_t digit = reply.code() - '1';
+    if (digit > 8) return -1;
+    return digit * 2 + reply.nozzleUp();
+}
+
+typedef enum : uint8_t {
+    STATUS_ACT_NONE,            // Статус ожидаем, состояние не меняется
+    STATUS_ACT_UNKNOWN,         // Нераспознанный статус: счётчик ошибок
+    STATUS_ACT_HUNG_UP,         // 90: рукав повешен после налива — снять разрешение
+    STATUS_ACT_READY,           // 10: ТРК свободна
+    STATUS_ACT_NOZZLE_UP,       // 21: рукав снят без заказа
+    STATUS_ACT_NOZZLE_UP_LONG,  // 21 при проверке связи: долгое снятие — ошибка
+    STATUS_ACT_RESTORE_PAUSED,  // 71 при проверке связи: налив на паузе
+    STATUS_ACT_RESTORE_DISPENSING, // 61 при проверке связи: налив идёт
+    STATUS_ACT_DISPENSING,      // 61: налив идёт, мониторинг литров
+    STATUS_ACT_PAUSED,          // 71: ТРК на паузе
+    STATUS_ACT_TRANSACTION_IDLE, // 10/21/90 во время налива: транзакция снята
+    STATUS_ACT_STOPPED,         // 81: налив окончен
+    STATUS_ACT_PAUSED_END,      // 90 на паузе: рукав повешен
+    STATUS_ACT_PAUSE_CONFIRMED, // 71 на паузе: команда B исполнена
+    STATUS_ACT_PAUSE_PENDING,   // Иное на паузе: повтор B или возврат к наливу
+    STATUS_ACT_STOP_PENDING,    // 3/4/6 после отмены: повтор N или ошибка
+    STATUS_ACT_COUNT
+} StatusActionId;
+
+// code = 0 — любой статус, для которого нет своей строки
+struct StatusTransition {
+    FSMState state;
+    char code;
+    bool nozzleUp;
+    StatusActionId action;
 };
 
-static const StatusAction statusActions[] = {
-    {{'1', '0'}, FSM_STATE_IDLE, true, nullptr},
-    {{'2', '1'}, FSM_STATE_IDLE, true, "Nozzle up! Hang up"},
-    {{'3', '1'}, FSM_STATE_TRANSACTION, false, nullptr},
-    {{'4', '1'}, FSM_STATE_TRANSACTION, false, nullptr},
-    {{'6', '1'}, FSM_STATE_TRANSACTION, false, nullptr},
-    {{'7', '1'}, FSM_STATE_TRANSACTION_PAUSED, false, nullptr},
-    {{'8', '1'}, FSM_STATE_TRANSACTION_END, true, nullptr},
-    {{'9', '0'}, FSM_STATE_IDLE, true, nullptr}
+static constexpr StatusTransition statusTransitions[] = {
+    {FSM_STATE_CHECK_STATUS, '9', false, STATUS_ACT_HUNG_UP},
+    {FSM_STATE_CHECK_STATUS, '1', false, STATUS_ACT_READY},
+    {FSM_STATE_CHECK_STATUS, '2', true,  STATUS_ACT_NOZZLE_UP_LONG},
+    {FSM_STATE_CHECK_STATUS, '7', true,  STATUS_ACT_RESTORE_PAUSED},
+    {FSM_STATE_CHECK_STATUS, '6', true,  STATUS_ACT_RESTORE_DISPENSING},
+    {FSM_STATE_CHECK_STATUS, 0,   false, STATUS_ACT_UNKNOWN},
+
+    {FSM_STATE_IDLE, '9', false, STATUS_ACT_HUNG_UP},
+    {FSM_STATE_IDLE, '1', false, STATUS_ACT_READY},
+    {FSM_STATE_IDLE, '2', true,  STATUS_ACT_NOZZLE_UP},
+    {FSM_STATE_IDLE, '3', true,  STATUS_ACT_STOP_PENDING},
+    {FSM_STATE_IDLE, '4', true,  STATUS_ACT_STOP_PENDING},
+    {FSM_STATE_IDLE, '6', true,  STATUS_ACT_STOP_PENDING},
+    {FSM_STATE_IDLE, 0,   false, STATUS_ACT_UNKNOWN},
+
+    {FSM_STATE_TRANSACTION, '1', false, STATUS_ACT_TRANSACTION_IDLE},
+    {FSM_STATE_TRANSACTION, '2', true,  STATUS_ACT_TRANSACTION_IDLE},
+    {FSM_STATE_TRANSACTION, '3', true,  STATUS_ACT_NONE},
+    {FSM_STATE_TRANSACTION, '4', true,  STATUS_ACT_NONE},
+    {FSM_STATE_TRANSACTION, '6', true,  STATUS_ACT_DISPENSING},
+    {FSM_STATE_TRANSACTION, '7', true,  STATUS_ACT_PAUSED},
+    {FSM_STATE_TRANSACTION, '8', true,  STATUS_ACT_STOPPED},
+    {FSM_STATE_TRANSACTION, '9', false, STATUS_ACT_TRANSACTION_IDLE},
+
+    {FSM_STATE_TRANSACTION_PAUSED, '9', false, STATUS_ACT_PAUSED_END},
+    {FSM_STATE_TRANSACTION_PAUSED, '7', true,  STATUS_ACT_PAUSE_CONFIRMED},
+    {FSM_STATE_TRANSACTION_PAUSED, 0,   false, STATUS_ACT_PAUSE_PENDING}
 };
 
-static bool isValidStatus(uint8_t* buffer) {
-    for (size_t i = 0; i < sizeof(statusActions) / sizeof(statusActions[0]); i++) {
-        if (buffer[4] == statusActions[i].code[0] && buffer[5] == statusActions[i].code[1]) {
-            return true;
-        }
+#define STATUS_TRANSITION_COUNT (sizeof(statusTransitions) / sizeof(statusTransitions[0]))
+
+// Поиск при компиляции: своя строка (state, status), иначе строка «любой статус» состояния
+static constexpr bool transitionMatches(uint8_t i, uint8_t state, uint8_t status) {
+    return statusTransitions[i].state == state && statusTransitions[i].code != 0 &&
+           statusIndex(statusTransitions[i].code, statusTransitions[i].nozzleUp) == status;
+}
+
+static constexpr uint8_t defaultAction(uint8_t state, uint8_t i = 0) {
+    return i == STATUS_TRANSITION_COUNT ? (uint8_t)STATUS_ACT_NONE
+         : statusTransitions[i].state == state && statusTransitions[i].code == 0 ? (uint8_t)statusTransitions[i].action
+         : defaultAction(state, i + 1);
+}
+
+static constexpr uint8_t lookupAction(uint8_t state, uint8_t status, uint8_t i = 0) {
+    return i == STATUS_TRANSITION_COUNT ? defaultAction(state)
+         : transitionMatches(i, state, status) ? (uint8_t)statusTransitions[i].action
+         : lookupAction(state, status, i + 1);
+}
+
+// Проверки таблицы при компиляции
+static constexpr bool transitionValid(uint8_t i) {
+    return statusTransitions[i].state < FSM_STATE_COUNT && statusTransitions[i].action < STATUS_ACT_COUNT &&
+           (statusTransitions[i].code == 0 || (statusTransitions[i].code >= '1' && statusTransitions[i].code <= '9'));
+}
+
+static constexpr bool sameKey(uint8_t i, uint8_t j) {
+    return statusTransitions[i].state == statusTransitions[j].state && statusTransitions[i].code == statusTransitions[j].code &&
+           (statusTransitions[i].code == 0 || statusTransitions[i].nozzleUp == statusTransitions[j].nozzleUp);
+}
+
+static constexpr bool keyRepeats(uint8_t i, uint8_t j) {
+    return j < STATUS_TRANSITION_COUNT && (sameKey(i, j) || keyRepeats(i, j + 1));
+}
+
+static constexpr bool transitionsWellFormed(uint8_t i = 0) {
+    return i == STATUS_TRANSITION_COUNT || (transitionValid(i) && !keyRepeats(i, i + 1) && transitionsWellFormed(i + 1));
+}
+
+static_assert(transitionsWellFormed(), "statusTransitions: bad state, action or status code, or a repeated (state, status) pair");
+
+// Статусы, которые протокол знает (строка с кодом хотя бы в одном состоянии): они сбрасывают счётчик ошибок
+static constexpr uint32_t knownStatuses(uint8_t i = 0) {
+    return i == STATUS_TRANSITION_COUNT ? 0
+         : (statusTransitions[i].code ? (uint32_t)1 << statusIndex(statusTransitions[i].code, statusTransitions[i].nozzleUp) : 0) |
+           knownStatuses(i + 1);
+}
+
+static bool statusRecognised(StatusReply reply) {
+    int8_t status = statusIndex(reply);
+    return status >= 0 && ((knownStatuses() >> status) & 1);
+}
+
+// Прямой индекс [состояние][статус] -> действие; строится при компиляции и лежит во флеш-памяти
+#define STATUS_ROW(state) {lookupAction(state, 0), lookupAction(state, 1), lookupAction(state, 2), lookupAction(state, 3), \
+    lookupAction(state, 4), lookupAction(state, 5), lookupAction(state, 6), lookupAction(state, 7), lookupAction(state, 8), \
+    lookupAction(state, 9), lookupAction(state, 10), lookupAction(state, 11), lookupAction(state, 12), lookupAction(state, 13), \
+    lookupAction(state, 14), lookupAction(state, 15), lookupAction(state, 16), lookupAction(state, 17)}
+
+static const uint8_t statusDispatch[FSM_STATE_COUNT][STATUS_CODE_COUNT] PROGMEM = {
+    STATUS_ROW(0), STATUS_ROW(1), STATUS_ROW(2), STATUS_ROW(3), STATUS_ROW(4), STATUS_ROW(5), STATUS_ROW(6),
+    STATUS_ROW(7), STATUS_ROW(8), STATUS_ROW(9), STATUS_ROW(10), STATUS_ROW(11), STATUS_ROW(12)
+};
+static_assert(FSM_STATE_COUNT == 13, "statusDispatch needs one STATUS_ROW per FSM state");
+
+/* Действия при входе в состояние и выходе из него */
+typedef void (*StateHook)(FSMContext* ctx);
+
+struct StateHooks {
+    StateHook entry;
+    StateHook exit;
+};
+
+static void enterPaused(FSMContext* ctx) {
+    displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_PAUSED);
+    saveTransactionState(ctx->post, ctx->activeNozzle, ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+}
+
+static void exitPaused(FSMContext* ctx) {
+    ctx->pauseUnconfirmed = false;
+}
+
+static void enterTransactionEnd(FSMContext* ctx) {
+    requestTransactionUpdate(ctx);
+    saveTransactionState(ctx->post, ctx->activeNozzle, ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+}
+
+static const StateHooks stateHooks[FSM_STATE_COUNT] PROGMEM = {
+    {nullptr, nullptr},                 // CHECK_STATUS
+    {nullptr, nullptr},                 // IDLE
+    {nullptr, nullptr},                 // WAIT_FOR_PRICE_INPUT
+    {nullptr, nullptr},                 // VIEW_PRICE
+    {nullptr, nullptr},                 // TRANSITION_PRICE_SET
+    {nullptr, nullptr},                 // EDIT_PRICE
+    {nullptr, nullptr},                 // TRANSITION_EDIT_PRICE
+    {nullptr, nullptr},                 // ERROR
+    {nullptr, nullptr},                 // TRANSACTION
+    {enterTransactionEnd, nullptr},     // TRANSACTION_END
+    {nullptr, nullptr},                 // TOTAL_COUNTER
+    {enterPaused, exitPaused},          // TRANSACTION_PAUSED
+    {nullptr, nullptr}                  // CONFIRM_TRANSACTION
+};
+
+static void enterState(FSMContext* ctx, FSMState next) {
+    StateHook hook = (StateHook)pgm_read_ptr(&stateHooks[ctx->state].exit);
+    if (hook) hook(ctx);
+    ctx->state = next;
+    ctx->stateEntryTime = millis();
+    hook = (StateHook)pgm_read_ptr(&stateHooks[next].entry);
+    if (hook) hook(ctx);
+}
+
+/* Действия переходов по статусу */
+typedef void (*StatusAction)(FSMContext* ctx);
+
+static void statusNone(FSMContext* ctx) {}
+
+static void statusUnknown(FSMContext* ctx) {
+    if (++ctx->errorCount >= MAX_ERROR_COUNT) {
+        enterError(ctx, TEXT_PUMP_ERROR);
     }
-    return false;
+}
+
+static void statusHungUp(FSMContext* ctx) {
+    requestNozzleOff(ctx);
+    ctx->stopUnconfirmed = false;
+    ctx->nozzleUpStartTime = 0;
+    ctx->nozzleUpWarning = false;
+}
+
+static void statusReady(FSMContext* ctx) {
+    if (ctx->state != FSM_STATE_IDLE) enterState(ctx, FSM_STATE_IDLE);
+    ctx->stopUnconfirmed = false;
+    ctx->nozzleUpWarning = false;
+    ctx->nozzleUpStartTime = 0;
+    displayIdle(ctx);
+}
+
+static void statusNozzleUp(FSMContext* ctx) {
+    requestNozzleOff(ctx);
+    ctx->stopUnconfirmed = false;
+    ctx->nozzleUpWarning = true;
+    if (ctx->nozzleUpStartTime == 0) {
+        ctx->nozzleUpStartTime = millis();
+    }
+    showText(ctx, TEXT_NOZZLE_UP);
+}
+
+static void statusNozzleUpLong(FSMContext* ctx) {
+    statusNozzleUp(ctx);
+    if (elapsed(millis(), ctx->nozzleUpStartTime) > 60000) {
+        enterError(ctx, TEXT_NOZZLE_UP_LONG);
+    }
+}
+
+static void statusRestorePaused(FSMContext* ctx) {
+    ctx->monitorActive = true;
+    enterState(ctx, FSM_STATE_TRANSACTION_PAUSED);
+}
+
+static void statusRestoreDispensing(FSMContext* ctx) {
+    enterState(ctx, FSM_STATE_TRANSACTION);
+    ctx->monitorActive = true;
+    ctx->transactionStarted = true;
+    ctx->waitingForResponse = PumpDriver::readLiveVolume(ctx->address, onTransactionReply, ctx);
+    displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_RESTORING);
+}
+
+static void statusDispensing(FSMContext* ctx) {
+    ctx->monitorActive = true;
+    ctx->waitingForResponse = PumpDriver::readLiveVolume(ctx->address, onTransactionReply, ctx);
+}
+
+static void statusPaused(FSMContext* ctx) {
+    enterState(ctx, FSM_STATE_TRANSACTION_PAUSED);
+}
+
+static void statusTransactionIdle(FSMContext* ctx) {
+    ctx->errorCount = 0;
+    enterState(ctx, FSM_STATE_IDLE);
+}
+
+static void statusStopped(FSMContext* ctx) {
+    ctx->errorCount = 0;
+    enterState(ctx, FSM_STATE_TRANSACTION_END);
+    displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_TRANS_STOPPED);
+}
+
+static void statusPausedEnd(FSMContext* ctx) {
+    enterState(ctx, FSM_STATE_TRANSACTION_END);
+}
+
+static void statusPauseConfirmed(FSMContext* ctx) {
+    ctx->pauseUnconfirmed = false;
+}
+
+static void statusPausePending(FSMContext* ctx) {
+    if (ctx->pauseUnconfirmed && elapsed(millis(), ctx->stateEntryTime) < PAUSE_CONFIRM_TIMEOUT) {
+        // ТРК ещё отпускает топливо: пауза не дошла или не исполнена — B повторяется
+        PumpDriver::pause(ctx->address, onControlDelivered, ctx);
+        return;
+    }
+    bool failed = ctx->pauseUnconfirmed;
+    ctx->monitorActive = true;
+    enterState(ctx, FSM_STATE_TRANSACTION);
+    displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
+    // Пауза так и не подтвердилась: налив идёт дальше, оператор видит отказ
+    if (failed) showToast(ctx, TEXT_STOP_PAUSE_FAILED);
+}
+
+static void statusStopPending(FSMContext* ctx) {
+    if (!ctx->stopUnconfirmed) {
+        statusUnknown(ctx);
+        return;
+    }
+    if (elapsed(millis(), ctx->stateEntryTime) < STOP_CONFIRM_TIMEOUT) {
+        // ТРК всё ещё с разрешением налива: стоп не дошёл или не исполнен — N повторяется
+        PumpDriver::stop(ctx->address, onControlDelivered, ctx);
+        return;
+    }
+    ctx->stopUnconfirmed = false;
+    enterError(ctx, TEXT_STOP_PAUSE_FAILED);
+}
+
+// Порядок — как в StatusActionId
+static const StatusAction statusActions[STATUS_ACT_COUNT] PROGMEM = {
+    statusNone,
+    statusUnknown,
+    statusHungUp,
+    statusReady,
+    statusNozzleUp,
+    statusNozzleUpLong,
+    statusRestorePaused,
+    statusRestoreDispensing,
+    statusDispensing,
+    statusPaused,
+    statusTransactionIdle,
+    statusStopped,
+    statusPausedEnd,
+    statusPauseConfirmed,
+    statusPausePending,
+    statusStopPending
+};
+
+// Время выполнения переходов по действию: число и максимум (мкс)
+struct TransitionTiming {
+    uint16_t count;
+    uint16_t maxMicros;
+};
+static TransitionTiming transitionTiming[STATUS_ACT_COUNT];
+
+static void dispatchStatus(FSMContext* ctx, StatusReply reply) {
+    int8_t status = statusIndex(reply);
+    uint8_t action = status >= 0 ? pgm_read_byte(&statusDispatch[ctx->state][status]) : defaultAction(ctx->state);
+    unsigned long start = micros();
+    ((StatusAction)pgm_read_ptr(&statusActions[action]))(ctx);
+    unsigned long spent = micros() - start;
+    TransitionTiming* timing = &transitionTiming[action];
+    timing->count++;
+    if (spent > timing->maxMicros) timing->maxMicros = spent > 0xFFFF ? 0xFFFF : spent;
 }
 
 /* Обновление состояний FSM */
+static void onCheckStatusReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_CHECK_STATUS);
+    if (!ctx) return;
+
+    if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
+        StatusReply reply(respBuffer);
+        trackNozzle(ctx, reply);
+        dispatchStatus(ctx, reply);
+    }
+}
+
 static void updateCheckStatus(FSMContext* ctx) {
+    if (!ctx->waitingForResponse) {
+        requestStatus(ctx, onCheckStatusReply);
+    }
+}
+
+// Ответы T и L пачки пересинхронизации: состояние транзакции читается с ТРК
+static void finishResync(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    static unsigned long nozzleUpStartTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
+    uint16_t resyncMs = elapsed(currentMillis, ctx->stateEntryTime);
+    char code = ctx->resyncStatus;
+    ctx->resyncStatus = 0;
+    ctx->waitingForResponse = false;
+    ctx->monitorActive = true;
+    ctx->transactionStarted = true;
+    // Экран паузы, повторный запрос итогов T и сохранение в EEPROM — в действиях входа состояний
+    if (code == '7') {
+        enterState(ctx, FSM_STATE_TRANSACTION_PAUSED);
+    } else if (code == '8') {
+        enterState(ctx, FSM_STATE_TRANSACTION_END);
+        displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_FILLING_END);
+    } else {
+        enterState(ctx, FSM_STATE_TRANSACTION);
+        displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
+        saveTransactionState(ctx->post, ctx->activeNozzle, ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+    }
+    recordRecovery(ctx, resyncMs);
+}
 
-    if (!ctx->waitingForResponse) {
-        rs422SendStatus();
-        ctx->waitingForResponse = true;
+static void onResyncReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_ERROR);
+    if (!ctx || ctx->resyncStatus == 0) return;
+
+    if (!MonitorReply::complete(respLength)) {
+        // Пачка сорвалась: снова пробные опросы с начальным периодом
+        ctx->resyncStatus = 0;
+        ctx->waitingForResponse = false;
+        ctx->stateEntryTime = millis();
+        return;
+    }
+    ReplyView reply(respBuffer);
+    if (reply.command() == 'T') {
+        TransactionEndReply(respBuffer).totals(&ctx->currentLiters_dL, &ctx->currentPriceTotal);
+        // После окончания налива L не нужен: итог уже в ответе T
+        if (ctx->resyncStatus == '8') finishResync(ctx);
+    } else if (reply.command() == 'L') {
+        MonitorReply(respBuffer).value(&ctx->currentLiters_dL);
+        finishResync(ctx);
+    }
+}
+
+static void onErrorReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_ERROR);
+    if (!ctx) return;
+    unsigned long currentMillis = millis();
+    ctx->waitingForResponse = false;
+    ctx->stateEntryTime = currentMillis;
+
+    // Пробный опрос без ответа или ТРК ещё не готова: следующий — через вдвое больший период
+    StatusReply reply(respBuffer);
+    bool complete = StatusReply::complete(respLength);
+    if (!complete || statusIs(reply, '9', false) || statusIs(reply, '2', true)) {
+        if ((uint32_t)RECONNECT_PROBE_MIN << ctx->probeStep < RECONNECT_PROBE_MAX) ctx->probeStep++;
     } else {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, STATUS_RESPONSE_LENGTH, 'S');
-        if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
-            if (respBuffer[4] == '9' && respBuffer[5] == '0') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-                nozzleUpStartTime = 0;
-            } else if (respBuffer[4] == '1' && respBuffer[5] == '0') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
-                ctx->nozzleUpWarning = false;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
-                nozzleUpStartTime = 0;
-            } else if (respBuffer[4] == '2' && respBuffer[5] == '1') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-                ctx->nozzleUpWarning = true;
-                if (nozzleUpStartTime == 0) {
-                    nozzleUpStartTime = currentMillis;
-                }
-                if (currentMillis - nozzleUpStartTime > 60000) {
-                    ctx->state = FSM_STATE_ERROR;
-                    ctx->stateEntryTime = currentMillis;
-                    displayMessage("Nozzle up long! Check");
-                } else {
-                    displayMessage("Nozzle up! Hang up");
-                }
-            } else if (respBuffer[4] == '7' && respBuffer[5] == '1') {
-                ctx->state = FSM_STATE_TRANSACTION_PAUSED;
-                ctx->stateEntryTime = currentMillis;
-                ctx->monitorActive = true;
-                ctx->monitorState = 0;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Paused", ctx->price > 9999);
-                saveTransactionState(ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-            } else if (respBuffer[4] == '6' && respBuffer[5] == '1') {
-                ctx->state = FSM_STATE_TRANSACTION;
-                ctx->stateEntryTime = currentMillis;
-                ctx->monitorActive = true;
-                ctx->monitorState = 1;
-                ctx->transactionStarted = true;
-                rs422SendLitersMonitor();
-                ctx->waitingForResponse = true;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Restoring trans...", ctx->price > 9999);
-            } else {
-                ctx->errorCount++;
-                if (ctx->errorCount >= MAX_ERROR_COUNT) {
-                    ctx->state = FSM_STATE_ERROR;
-                    ctx->stateEntryTime = currentMillis;
-                    displayMessage("Pump Error");
-                }
-            }
+        ctx->probeStep = 0;
+    }
+    if (!complete) return;
+
+    trackNozzle(ctx, reply);
+    if (statusIs(reply, '9', false)) {
+        requestNozzleOff(ctx);
+    } else if (statusIs(reply, '1', false)) {
+        enterState(ctx, FSM_STATE_IDLE);
+        ctx->nozzleUpWarning = false;
+        ctx->transactionStarted = false;
+        ctx->monitorActive = false;
+        ctx->errorCount = 0;
+        displayIdle(ctx);
+        recordRecovery(ctx, 0);
+    } else if (statusIs(reply, '2', true)) {
+        requestNozzleOff(ctx);
+        ctx->nozzleUpWarning = true;
+        showText(ctx, TEXT_NOZZLE_UP);
+    } else if (statusIs(reply, '3', true) || statusIs(reply, '4', true) || statusIs(reply, '6', true) ||
+               statusIs(reply, '7', true) || statusIs(reply, '8', true)) {
+        // Транзакция на ТРК продолжается: T и L одной пачкой, ответы идут подряд без возврата в цикл
+        ctx->resyncStatus = reply.code();
+        ctx->errorCount = 0;
+        ctx->waitingForResponse = PumpDriver::readFinalTotals(ctx->address, onResyncReply, ctx);
+        if (ctx->resyncStatus != '8') {
+            ctx->waitingForResponse &= PumpDriver::readLiveVolume(ctx->address, onResyncReply, ctx);
         }
+        if (!ctx->waitingForResponse) ctx->resyncStatus = 0;
+    } else {
+        enterState(ctx, FSM_STATE_CHECK_STATUS);
     }
 }
 
 static void updateError(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
-
-    if (currentMillis - ctx->stateEntryTime >= RESPONSE_TIMEOUT) {
-        rs422SendStatus();
-        ctx->waitingForResponse = true;
-        ctx->stateEntryTime = currentMillis;
-        displayMessage("Pump offline! Check");
+
+    uint16_t interval = min((uint32_t)RECONNECT_PROBE_MIN << ctx->probeStep, (uint32_t)RECONNECT_PROBE_MAX);
+    if (!ctx->waitingForResponse && elapsed(currentMillis, ctx->stateEntryTime) >= interval) {
+        ctx->waitingForResponse = PumpDriver::probeStatus(ctx->address, onErrorReply, ctx);
     }
-    if (ctx->waitingForResponse) {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, STATUS_RESPONSE_LENGTH, 'S');
-        if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
-            if (respBuffer[4] == '9' && respBuffer[5] == '0') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-            } else if (respBuffer[4] == '1' && respBuffer[5] == '0') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
-                ctx->nozzleUpWarning = false;
-                ctx->transactionStarted = false;
-                ctx->monitorActive = false;
-                ctx->monitorState = 0;
-                ctx->waitingForResponse = false;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
-            } else if (respBuffer[4] == '2' && respBuffer[5] == '1') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-                ctx->nozzleUpWarning = true;
-                displayMessage("Nozzle up! Hang up");
-            } else if (respBuffer[4] == '7' && respBuffer[5] == '1') {
-                ctx->state = FSM_STATE_TRANSACTION_PAUSED;
-                ctx->stateEntryTime = currentMillis;
-                ctx->monitorActive = true;
-                ctx->monitorState = 0;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Paused", ctx->price > 9999);
-                saveTransactionState(ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-            } else {
-                ctx->state = FSM_STATE_CHECK_STATUS;
-                ctx->stateEntryTime = currentMillis;
-                ctx->waitingForResponse = false;
-            }
-        }
+}
+
+static void onIdleReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_IDLE);
+    if (!ctx) return;
+
+    if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
+        StatusReply reply(respBuffer);
+        pollOnStatus(&ctx->poll, reply.codeBytes());
+        trackNozzle(ctx, reply);
+        dispatchStatus(ctx, reply);
     }
 }
 
 static void updateIdle(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    static unsigned long nozzleUpStartTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
 
     // Принудительный сброс nozzleUpWarning через 3 секунды после входа в IDLE
-    if (ctx->nozzleUpWarning && (currentMillis - ctx->stateEntryTime > 3000)) {
+    if (ctx->nozzleUpWarning && (elapsed(currentMillis, ctx->stateEntryTime) > 3000)) {
         ctx->nozzleUpWarning = false;
         ctx->errorCount = 0;
         Serial.println("Forced reset of nozzleUpWarning");
-        if (ctx->modeSelected) {
-            displayFuelMode(ctx->fuelMode);
-        } else {
-            displayMessage("Please select mode");
-        }
+        displayIdle(ctx);
     }
 
     if (ctx->skipFirstStatusCheck) {
         ctx->skipFirstStatusCheck = false;
         ctx->transactionStarted = false;
         ctx->monitorActive = false;
-        ctx->monitorState = 0;
         ctx->waitingForResponse = false;
-        if (ctx->modeSelected) {
-            displayFuelMode(ctx->fuelMode);
-        } else {
-            displayMessage("Please select mode");
-        }
+        displayIdle(ctx);
         return;
     }
-    if (ctx->statusPollingActive && !ctx->waitingForResponse) {
-        rs422SendStatus();
-        ctx->waitingForResponse = true;
-    } else if (ctx->waitingForResponse) {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, STATUS_RESPONSE_LENGTH, 'S');
-        if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
-            if (respBuffer[4] == '9' && respBuffer[5] == '0') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-                nozzleUpStartTime = 0;
-                ctx->nozzleUpWarning = false;
-            } else if (respBuffer[4] == '1' && respBuffer[5] == '0') {
-                ctx->nozzleUpWarning = false;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
-                nozzleUpStartTime = 0;
-            } else if (respBuffer[4] == '2' && respBuffer[5] == '1') {
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = true;
-                ctx->nozzleUpWarning = true;
-                if (nozzleUpStartTime = 0) {
-                    nozzleUpStartTime = currentMillis;
-                }
-                displayMessage("Nozzle up! Hang up");
-            } else {
-                ctx->errorCount++;
-                if (ctx->errorCount >= MAX_ERROR_COUNT) {
-                    ctx->state = FSM_STATE_ERROR;
-                    ctx->stateEntryTime = currentMillis;
-                    displayMessage("Pump Error");
-                }
-            }
-        }
+    pollSelect(&ctx->poll, POLL_PROFILE_IDLE);
+    if (ctx->statusPollingActive && !ctx->waitingForResponse && pollDue(&ctx->poll, currentMillis)) {
+        pollNext(&ctx->poll, currentMillis);
+        requestStatus(ctx, onIdleReply);
     }
 }
 
@@ -276,55 +713,39 @@ static void updateWaitForPriceInput(FSMContext* ctx) {
 
 static void updateViewPrice(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    if (currentMillis - ctx->stateEntryTime >= 10000) {
-        ctx->state = FSM_STATE_IDLE;
-        ctx->stateEntryTime = currentMillis;
+    if (elapsed(currentMillis, ctx->stateEntryTime) >= 10000) {
+        enterState(ctx, FSM_STATE_IDLE);
         if (!ctx->nozzleUpWarning) {
-            if (ctx->modeSelected) {
-                displayFuelMode(ctx->fuelMode);
-            } else {
-                displayMessage("Please select mode");
-            }
+            displayIdle(ctx);
         }
     }
 }
 
 static void updateTransitionPriceSet(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    if (currentMillis - ctx->stateEntryTime >= TRANSITION_TIMEOUT) {
+    if (elapsed(currentMillis, ctx->stateEntryTime) >= TRANSITION_TIMEOUT) {
         ctx->waitingForResponse = false;
-        ctx->state = FSM_STATE_CHECK_STATUS;
-        ctx->stateEntryTime = currentMillis;
+        enterState(ctx, FSM_STATE_CHECK_STATUS);
     }
 }
 
 static void updateTransitionEditPrice(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    if (currentMillis - ctx->stateEntryTime >= TRANSITION_TIMEOUT) {
+    if (elapsed(currentMillis, ctx->stateEntryTime) >= TRANSITION_TIMEOUT) {
         ctx->waitingForResponse = false;
-        ctx->state = FSM_STATE_IDLE;
-        ctx->stateEntryTime = currentMillis;
+        enterState(ctx, FSM_STATE_IDLE);
         if (!ctx->nozzleUpWarning) {
-            if (ctx->modeSelected) {
-                displayFuelMode(ctx->fuelMode);
-            } else {
-                displayMessage("Please select mode");
-            }
+            displayIdle(ctx);
         }
     }
 }
 
 static void updateEditPrice(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    if (currentMillis - ctx->stateEntryTime >= EDIT_TIMEOUT) {
-        ctx->state = FSM_STATE_IDLE;
-        ctx->stateEntryTime = currentMillis;
+    if (elapsed(currentMillis, ctx->stateEntryTime) >= EDIT_TIMEOUT) {
+        enterState(ctx, FSM_STATE_IDLE);
         if (!ctx->nozzleUpWarning) {
-            if (ctx->modeSelected) {
-                displayFuelMode(ctx->fuelMode);
-            } else {
-                displayMessage("Please select mode");
-            }
+            displayIdle(ctx);
         }
     }
 }
@@ -333,340 +754,274 @@ static void updateConfirmTransaction(FSMContext* ctx) {
     // Ждём действия пользователя, без таймаута
 }
 
-static void updateTransaction(FSMContext* ctx) {
-    unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
+static void onTransactionReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_TRANSACTION);
+    if (!ctx) return;
 
-    if (!ctx->waitingForResponse) {
-        if (!ctx->transactionStarted) {
-            rs422SendStatus();
-            ctx->waitingForResponse = true;
-        } else {
-            if (!ctx->monitorActive) {
-                rs422SendStatus();
-                ctx->waitingForResponse = true;
+    if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
+        StatusReply reply(respBuffer);
+        bool isStatus = reply.command() == 'S';
+        if (isStatus) trackNozzle(ctx, reply);
+        if (!ctx->transactionStarted && isStatus && statusIs(reply, '2', true)) { // Только S2n: рукав снят
+            // Налив разрешается на снятый рукав по его собственной цене
+            uint16_t price = currentNozzle(ctx)->price;
+            uint16_t protocolPrice = price > 9999 ? price / 10 : price;
+            if (!PumpDriver::authorize(ctx->address, ctx->activeNozzle, ctx->fuelMode, ctx->transactionTarget, protocolPrice)) {
+                // Заказ не принят (очередь шины занята): повтор со следующим статусом S2n
+                return;
+            }
+            ctx->transactionStarted = true;
+            ctx->currentLiters_dL = 0;
+            ctx->currentPriceTotal = 0;
+            ctx->errorCount = 0;
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
+            Serial.println("Transaction started");
+        } else if (isStatus) {
+            pollOnStatus(&ctx->poll, reply.codeBytes());
+            dispatchStatus(ctx, reply);
+        } else if (ctx->monitorActive && MonitorReply::complete(respLength)) {
+            // Неразборчивое значение оставляет последнее верное
+            MonitorReply monitor(respBuffer);
+            if (!nozzleFromDigit(monitor.nozzleDigit())) return;
+            if (monitor.command() == 'L') {
+                monitor.value(&ctx->currentLiters_dL);
+            } else if (monitor.command() == 'R') {
+                monitor.value(&ctx->currentPriceTotal);
             } else {
-                switch (ctx->monitorState) {
-                    case 0: rs422SendStatus(); break;
-                    case 1: rs422SendLitersMonitor(); break;
-                    case 2: rs422SendRevenueStatus(); break;
-                }
-                ctx->waitingForResponse = true;
+                return;
             }
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
         }
-    } else {
-        uint8_t respBuffer[32] = {0};
-        int expectedLength = ctx->monitorActive ? (ctx->monitorState == 0 ? STATUS_RESPONSE_LENGTH : MONITOR_RESPONSE_LENGTH) : STATUS_RESPONSE_LENGTH;
-        char expectedCommand = ctx->monitorState == 0 ? 'S' : (ctx->monitorState == 1 ? 'L' : 'R');
-        int respLength = rs422WaitForResponse(respBuffer, expectedLength, expectedCommand);
-        if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
-            if (!ctx->transactionStarted && respBuffer[4] == '2' && respBuffer[5] == '1') { // Только S21
-                uint16_t protocolPrice = ctx->price > 9999 ? ctx->price / 10 : ctx->price;
-                rs422SendTransaction(ctx->fuelMode, ctx->transactionVolume, ctx->transactionAmount, protocolPrice);
-                ctx->waitingForResponse = true;
-                ctx->transactionStarted = true;
-                ctx->currentLiters_dL = 0;
-                ctx->currentPriceTotal = 0;
-                ctx->errorCount = 0;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Dispensing...", ctx->price > 9999);
-                Serial.println("Transaction started");
-            } else if (ctx->monitorState == 0) {
-                if (isValidStatus(respBuffer)) {
-                    for (size_t i = 0; i < sizeof(statusActions) / sizeof(statusActions[0]); i++) {
-                        if (respBuffer[4] == statusActions[i].code[0] && respBuffer[5] == statusActions[i].code[1]) {
-                            ctx->state = statusActions[i].nextState;
-                            ctx->stateEntryTime = currentMillis;
-                            if (statusActions[i].resetErrorCount) ctx->errorCount = 0;
-                            if (statusActions[i].nextState == FSM_STATE_TRANSACTION_END) {
-                                rs422SendTransactionUpdate();
-                                ctx->waitingForResponse = true;
-                                if (respBuffer[4] == '9' && respBuffer[5] == '0') {
-                                    rs422SendNozzleOff();
-                                }
-                                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Trans stopped", ctx->price > 9999);
-                                saveTransactionState(ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-                            } else if (statusActions[i].nextState == FSM_STATE_TRANSACTION_PAUSED) {
-                                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Paused", ctx->price > 9999);
-                                saveTransactionState(ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-                            } else if (statusActions[i].nextState == FSM_STATE_TRANSACTION && respBuffer[4] == '6' && respBuffer[5] == '1') {
-                                ctx->monitorActive = true;
-                                ctx->monitorState = 1;
-                                rs422SendLitersMonitor();
-                                ctx->waitingForResponse = true;
-                            }
-                            break;
-                        }
-                    }
-                }
-            } else if (ctx->monitorActive) {
-                if (ctx->monitorState == 1 && respBuffer[3] == 'L' && respBuffer[4] == '1') {
-                    char litersStr[7] = {0};
-                    if (respLength >= 14) {
-                        memcpy(litersStr, respBuffer + 8, 6);
-                        bool valid = true;
-                        for (int i = 0; i < 6; i++) {
-                            if (litersStr[i] < '0' || litersStr[i] > '9') {
-                                valid = false;
-                                break;
-                            }
-                        }
-                        ctx->currentLiters_dL = valid ? atol(litersStr) : ctx->currentLiters_dL;
-                        displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Dispensing...", ctx->price > 9999);
-                    }
-                    ctx->monitorState = 2;
-                } else if (ctx->monitorState == 2 && respBuffer[3] == 'R' && respBuffer[4] == '1') {
-                    char priceStr[7] = {0};
-                    if (respLength >= 14) {
-                        memcpy(priceStr, respBuffer + 8, 6);
-                        bool valid = true;
-                        for (int i = 0; i < 6; i++) {
-                            if (priceStr[i] < '0' || priceStr[i] > '9') {
-                                valid = false;
-                                break;
-                            }
-                        }
-                        ctx->currentPriceTotal = valid ? atol(priceStr) : ctx->currentPriceTotal;
-                        displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Dispensing...", ctx->price > 9999);
-                    }
-                    ctx->monitorState = 0;
-                }
-            }
+    }
+}
+
+static void updateTransaction(FSMContext* ctx) {
+    unsigned long currentMillis = millis();
+
+    pollSelect(&ctx->poll, POLL_PROFILE_DISPENSING);
+    if (!ctx->waitingForResponse && pollDue(&ctx->poll, currentMillis)) {
+        char command = pollNext(&ctx->poll, currentMillis);
+        if (!ctx->transactionStarted || !ctx->monitorActive) command = 'S';
+        switch (command) {
+            case 'S': requestStatus(ctx, onTransactionReply); break;
+            case 'L': ctx->waitingForResponse = PumpDriver::readLiveVolume(ctx->address, onTransactionReply, ctx); break;
+            case 'R': ctx->waitingForResponse = PumpDriver::readLiveAmount(ctx->address, onTransactionReply, ctx); break;
         }
     }
 }
 
+static void onTransactionPausedReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_TRANSACTION_PAUSED);
+    if (!ctx) return;
+
+    if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
+        StatusReply reply(respBuffer);
+        pollOnStatus(&ctx->poll, reply.codeBytes());
+        trackNozzle(ctx, reply);
+        dispatchStatus(ctx, reply);
+    }
+}
+
 static void updateTransactionPaused(FSMContext* ctx) {
     unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
-
-    if (currentMillis - ctx->stateEntryTime > 30000) {
-        ctx->finalLiters_dL = ctx->currentLiters_dL;
-        ctx->finalPriceTotal = ctx->currentPriceTotal;
-        rs422SendTransactionUpdate();
-        ctx->waitingForResponse = true;
-        ctx->state = FSM_STATE_TRANSACTION_END;
-        ctx->stateEntryTime = currentMillis;
-        displayMessage("Nozzle back! Trans end");
-        saveTransactionState(ctx->finalLiters_dL, ctx->finalPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+
+    if (elapsed(currentMillis, ctx->stateEntryTime) > 30000) {
+        enterState(ctx, FSM_STATE_TRANSACTION_END);
+        showText(ctx, TEXT_NOZZLE_BACK);
         return;
     }
 
-    if (!ctx->waitingForResponse) {
-        rs422SendStatus();
-        ctx->waitingForResponse = true;
-    } else {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, STATUS_RESPONSE_LENGTH, 'S');
-        if (handleResponse(respBuffer, respLength, STATUS_RESPONSE_LENGTH, ctx)) {
-            if (respBuffer[4] == '9' && respBuffer[5] == '0') {
-                ctx->finalLiters_dL = ctx->currentLiters_dL;
-                ctx->finalPriceTotal = ctx->currentPriceTotal;
-                rs422SendTransactionUpdate();
-                ctx->waitingForResponse = true;
-                ctx->state = FSM_STATE_TRANSACTION_END;
-                ctx->stateEntryTime = currentMillis;
-                saveTransactionState(ctx->finalLiters_dL, ctx->finalPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-            } else if (respBuffer[4] != '7' || respBuffer[5] != '1') {
-                ctx->monitorActive = true;
-                ctx->monitorState = 0;
-                ctx->state = FSM_STATE_TRANSACTION;
-                ctx->stateEntryTime = currentMillis;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Dispensing...", ctx->price > 9999);
+    pollSelect(&ctx->poll, POLL_PROFILE_PAUSED);
+    if (!ctx->waitingForResponse && pollDue(&ctx->poll, currentMillis)) {
+        pollNext(&ctx->poll, currentMillis);
+        requestStatus(ctx, onTransactionPausedReply);
+    }
+}
+
+static void onTransactionEndReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_TRANSACTION_END);
+    if (!ctx) return;
+
+    if (TransactionEndReply::complete(respLength)) {
+        ctx->waitingForResponse = false;
+        TransactionEndReply reply(respBuffer);
+        uint8_t nozzle = nozzleFromDigit(reply.nozzleDigit());
+        if (reply.command() == 'T' && nozzle) {
+            if (reply.totals(&ctx->currentLiters_dL, &ctx->currentPriceTotal)) {
+                NozzleState* record = &ctx->nozzles[nozzle - 1];
+                record->lastLiters_dL = ctx->currentLiters_dL;
+                record->lastAmount = ctx->currentPriceTotal;
+            } else {
+                Serial.println("Invalid transaction data, using last valid values");
             }
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_FILLING_END);
+            requestNozzleOff(ctx);
+            ctx->transactionDataReceived = true;
+            ctx->errorCount = 0;
+            saveTransactionState(ctx->post, ctx->activeNozzle, ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+            Serial.print("Transaction end: Liters=");
+            Serial.print(ctx->currentLiters_dL);
+            Serial.print(", Price=");
+            Serial.println(ctx->currentPriceTotal);
+        } else if (++ctx->errorCount >= MAX_ERROR_COUNT) {
+            enterError(ctx, TEXT_TRANS_ERROR);
         }
+    } else {
+        // Бюджет повторов T исчерпан
+        ctx->waitingForResponse = false;
+        enterError(ctx, TEXT_TRANS_ERROR);
+        Serial.println("Transaction data error after retries");
     }
 }
 
 static void updateTransactionEnd(FSMContext* ctx) {
-    unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    static bool dataReceived = false;
-    static uint8_t retryCount = 0;
+    // Повторы T после потерь делает шина; здесь — только если запрос не встал в очередь
+    if (!ctx->waitingForResponse && !ctx->transactionDataReceived) {
+        requestTransactionUpdate(ctx);
+        Serial.println("Requesting transaction update");
+    }
+}
 
-    if (ctx->stateEntryTime == currentMillis) {
-        dataReceived = false;
-        retryCount = 0;
+static void displayTotal(const FSMContext* ctx) {
+    char displayStr[32];
+    char* end = appendText(displayStr, "TOTAL N");
+    end = formatUnsigned(end, ctx->selectedNozzle);
+    end = appendText(end, ":\n");
+    uint32_t total = ctx->nozzles[ctx->selectedNozzle - 1].totalizer_mL;
+    if (total == TOTALIZER_UNKNOWN) {
+        // Цикл до рукава ещё не дошёл — ждём; рукав опрошен, но счётчик не прочитан — n/a
+        if (ctx->totalNozzle && ctx->selectedNozzle >= ctx->totalNozzle) {
+            showText(ctx, TEXT_TOTAL_WAITING);
+            return;
+        }
+        appendText(end, "n/a");
+    } else {
+        // Счётчик в мл выводится в литрах с двумя знаками (до 10 мл)
+        formatFixed(end, total / 10, 2);
     }
+    showMessage(ctx, displayStr);
+}
 
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
-
-    if (!ctx->waitingForResponse && !dataReceived && retryCount < 5) {
-        rs422SendTransactionUpdate();
-        ctx->waitingForResponse = true;
-        retryCount++;
-        Serial.print("Requesting transaction update, attempt: ");
-        Serial.println(retryCount);
-    } else if (ctx->waitingForResponse) {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, TRANSACTION_END_RESPONSE_LENGTH, 'T');
-        if (respLength >= 18) {
-            ctx->waitingForResponse = false;
-            ctx->errorCount = 0;
-            if (respBuffer[3] == 'T' && respBuffer[4] == '1') {
-                char priceStr[7] = {0};
-                char litersStr[7] = {0};
-                int offset = (respBuffer[5] == 'u') ? 10 : 8;
-                memcpy(priceStr, respBuffer + offset, 6);
-                memcpy(litersStr, respBuffer + offset + 7, 6);
-                bool valid = true;
-                for (int i = 0; i < 6; i++) {
-                    if (litersStr[i] < '0' || litersStr[i] > '9' || priceStr[i] < '0' || priceStr[i] > '9') {
-                        valid = false;
-                        break;
-                    }
-                }
-                if (valid) {
-                    ctx->finalLiters_dL = atol(litersStr);
-                    ctx->finalPriceTotal = atol(priceStr);
-                } else {
-                    Serial.println("Invalid transaction data, using last valid values");
-                }
-                displayTransaction(ctx->finalLiters_dL, ctx->finalPriceTotal, "Filling end", ctx->price > 9999);
-                rs422SendNozzleOff();
-                ctx->waitingForResponse = false;
-                dataReceived = true;
-                retryCount = 0;
-                saveTransactionState(ctx->finalLiters_dL, ctx->finalPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
-                Serial.print("Transaction end: Liters=");
-                Serial.print(ctx->finalLiters_dL);
-                Serial.print(", Price=");
-                Serial.println(ctx->finalPriceTotal);
-            }
+static void onTotalCounterReply(void* context, Rs422RxStatus status, const uint8_t* respBuffer, int respLength) {
+    FSMContext* ctx = replyContext(context, FSM_STATE_TOTAL_COUNTER);
+    if (!ctx) return;
+    ctx->waitingForResponse = false;
+    uint8_t nozzle = ctx->totalNozzle;
+
+    // Неудача (повторы C исчерпаны) отмечается только у этого рукава, цикл идёт дальше
+    TotalCounterReply reply(respBuffer);
+    bool valid = TotalCounterReply::complete(respLength) && nozzleFromDigit(reply.nozzleDigit()) == nozzle &&
+                 reply.total(&ctx->nozzles[nozzle - 1].totalizer_mL);
+    if (!valid) ctx->nozzles[nozzle - 1].totalizer_mL = TOTALIZER_UNKNOWN;
+    if (nozzle == ctx->selectedNozzle) {
+        if (valid) {
+            displayTotal(ctx);
         } else {
-            ctx->waitingForResponse = false;
-            ctx->errorCount++;
-            retryCount++;
-            if (retryCount >= 5) {
-                ctx->state = FSM_STATE_ERROR;
-                ctx->stateEntryTime = currentMillis;
-                displayMessage("Trans error! Check pump");
-                Serial.println("Transaction data error after retries");
-            }
+            showText(ctx, TEXT_TOTAL_ERROR);
         }
     }
+    // Счётчики всех рукавов поста за один проход: следующий запрос сразу за ответом
+    ctx->totalNozzle = nozzle < NOZZLE_COUNT ? nozzle + 1 : 0;
+    if (ctx->totalNozzle) {
+        ctx->waitingForResponse = PumpDriver::readTotalizer(ctx->address, ctx->totalNozzle, onTotalCounterReply, ctx);
+    }
 }
 
 static void updateTotalCounter(FSMContext* ctx) {
-    unsigned long currentMillis = millis();
-    static unsigned long lastResponseTime = 0;
-    if (currentMillis - lastResponseTime < DELAY_AFTER_RESPONSE) return;
-    lastResponseTime = currentMillis;
-
-    if (!ctx->waitingForResponse && ctx->c0RetryCount < MAX_ERROR_COUNT && (currentMillis - ctx->lastC0SendTime) >= RESPONSE_TIMEOUT) {
-        rs422SendTotalCounter();
-        ctx->waitingForResponse = true;
-        ctx->lastC0SendTime = currentMillis;
-        ctx->c0RetryCount++;
-    } else if (ctx->waitingForResponse) {
-        uint8_t respBuffer[32] = {0};
-        int respLength = rs422WaitForResponse(respBuffer, TOTAL_COUNTER_RESPONSE_LENGTH, 'C');
-        if (handleResponse(respBuffer, respLength, TOTAL_COUNTER_RESPONSE_LENGTH, ctx)) {
-            if (respBuffer[3] == 'C' && respBuffer[4] == '1') {
-                char totalStr[10] = {0};
-                memcpy(totalStr, respBuffer + 6, 9);
-                bool valid = true;
-                for (int i = 0; i < 9; i++) {
-                    if (totalStr[i] < '0' || totalStr[i] > '9') {
-                        valid = false;
-                        break;
-                    }
-                }
-                if (valid) {
-                    uint32_t totalLiters_mL = atol(totalStr);
-                    char litersBuf[12];
-                    formatLiters(totalLiters_mL / 10, litersBuf, sizeof(litersBuf));
-                    char displayStr[32];
-                    snprintf(displayStr, sizeof(displayStr), "TOTAL:\n%s", litersBuf);
-                    displayMessage(displayStr);
-                } else {
-                    displayMessage("TOTAL:\nError");
-                }
-                ctx->waitingForResponse = false;
-                ctx->c0RetryCount = MAX_ERROR_COUNT;
-            } else {
-                if (ctx->c0RetryCount >= MAX_ERROR_COUNT) {
-                    displayMessage("TOTAL:\nError");
-                }
-            }
-        }
+    // Запрос, не вставший в очередь, ставится снова
+    if (!ctx->waitingForResponse && ctx->totalNozzle) {
+        ctx->waitingForResponse = PumpDriver::readTotalizer(ctx->address, ctx->totalNozzle, onTotalCounterReply, ctx);
     }
 }
 
 /* Инициализация FSM */
-void initFSM(FSMContext* ctx) {
+void initFSM(FSMContext* ctx, uint8_t post) {
     Serial.begin(9600);
-    rs422SendNozzleOff();
-    ctx->price = readPriceFromEEPROM();
-    ctx->priceValid = ctx->price > 0;
+    ctx->post = post;
+    ctx->address = POST_ADDRESSES[post];
+    if (displayOwner == nullptr) displayOwner = ctx;
+    requestNozzleOff(ctx);
+    for (uint8_t i = 0; i < NOZZLE_COUNT; i++) {
+        NozzleState* nozzle = &ctx->nozzles[i];
+        nozzle->price = readPriceFromEEPROM(post, i + 1);
+        nozzle->totalizer_mL = TOTALIZER_UNKNOWN;
+        nozzle->lastLiters_dL = 0;
+        nozzle->lastAmount = 0;
+    }
+    ctx->selectedNozzle = 1;
+    ctx->activeNozzle = 0;
+    ctx->totalNozzle = 1;
+    ctx->priceValid = ctx->nozzles[0].price > 0;
     ctx->fuelMode = FUEL_BY_VOLUME;
     ctx->stateEntryTime = millis();
     ctx->waitingForResponse = false;
     ctx->errorCount = 0;
-    ctx->c0RetryCount = 0;
-    ctx->lastC0SendTime = 0;
+    ctx->probeStep = 0;
+    ctx->resyncStatus = 0;
+    ctx->offlineSince = 0;
     ctx->statusPollingActive = true;
-    ctx->transactionVolume = 0;
-    ctx->transactionAmount = 0;
+    ctx->transactionTarget = 0;
     ctx->transactionStarted = false;
-    ctx->monitorState = 0;
     ctx->monitorActive = false;
+    initPoll(&ctx->poll, POLL_PROFILE_IDLE);
     ctx->currentLiters_dL = 0;
-    ctx->finalLiters_dL = 0;
     ctx->currentPriceTotal = 0;
-    ctx->finalPriceTotal = 0;
     ctx->nozzleUpWarning = false;
     ctx->skipFirstStatusCheck = false;
-    ctx->lastKeyTime = 0;
-    ctx->priceInput[0] = '\0';
+    ctx->nozzleUpStartTime = 0;
+    ctx->transactionDataReceived = false;
+    ui.priceInput[0] = '\0';
     ctx->modeSelected = false;
+    ctx->pauseUnconfirmed = false;
+    ctx->stopUnconfirmed = false;
 
     // Проверка сохранённой транзакции
     uint32_t savedLiters, savedPrice;
+    uint8_t savedNozzle;
     FSMState savedState;
     FuelMode savedMode;
     bool savedModeSelected;
-    if (restoreTransactionState(&savedLiters, &savedPrice, &savedState, &savedMode, &savedModeSelected)) {
+    if (restoreTransactionState(ctx->post, &savedNozzle, &savedLiters, &savedPrice, &savedState, &savedMode, &savedModeSelected)) {
         ctx->currentLiters_dL = savedLiters;
         ctx->currentPriceTotal = savedPrice;
         ctx->state = savedState;
         if (savedState == FSM_STATE_TRANSACTION || savedState == FSM_STATE_TRANSACTION_PAUSED) {
             ctx->fuelMode = savedMode;
             ctx->modeSelected = savedModeSelected;
+            ctx->activeNozzle = savedNozzle;
             ctx->transactionStarted = true;
             ctx->monitorActive = true;
-            ctx->monitorState = 1;
-            displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Restoring trans...", ctx->price > 9999);
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_RESTORING);
         } else {
             // Игнорируем сохранённый режим для неактивных транзакций
             ctx->state = ctx->priceValid ? FSM_STATE_CHECK_STATUS : FSM_STATE_WAIT_FOR_PRICE_INPUT;
             if (!ctx->priceValid) {
-                displayMessage("Set price (0-99999)");
+                showText(ctx, TEXT_SET_PRICE);
             } else {
-                displayMessage("Please select mode");
+                showText(ctx, TEXT_SELECT_MODE);
             }
         }
     } else {
         ctx->state = ctx->priceValid ? FSM_STATE_CHECK_STATUS : FSM_STATE_WAIT_FOR_PRICE_INPUT;
         if (!ctx->priceValid) {
-            displayMessage("Set price (0-99999)");
+            showText(ctx, TEXT_SET_PRICE);
         } else {
-            displayMessage("Please select mode");
+            showText(ctx, TEXT_SELECT_MODE);
         }
     }
 
     if (ctx->state == FSM_STATE_CHECK_STATUS) {
-        rs422SendStatus();
-        ctx->waitingForResponse = true;
+        requestStatus(ctx, onCheckStatusReply);
     }
 }
 
 /* Основной цикл FSM */
 void updateFSM(FSMContext* ctx) {
+    // Посты с идущим наливом обслуживаются на шине в первую очередь
+    PumpDriver::setPriority(ctx->address, ctx->state == FSM_STATE_TRANSACTION ||
+                                       ctx->state == FSM_STATE_TRANSACTION_PAUSED ||
+                                       ctx->state == FSM_STATE_TRANSACTION_END);
+    if (ctx->nozzleOffPending) requestNozzleOff(ctx);
     switch (ctx->state) {
         case FSM_STATE_CHECK_STATUS:        updateCheckStatus(ctx); break;
         case FSM_STATE_ERROR:               updateError(ctx); break;
@@ -688,11 +1043,13 @@ void updateFSM(FSMContext* ctx) {
 /* Управление вводом клавиш */
 void processKeyFSM(FSMContext* ctx, char key) {
     unsigned long currentMillis = millis();
-    if (currentMillis - ctx->lastKeyTime < KEY_DEBOUNCE_MS) {
-        displayMessage("Slow down! Wait");
+    if (elapsed(currentMillis, ui.lastKeyTime) < KEY_DEBOUNCE_MS) {
+        showToast(ctx, TEXT_SLOW_DOWN);
         return;
     }
-    ctx->lastKeyTime = currentMillis;
+    ui.lastKeyTime = currentMillis;
+    // Действие оператора: статус ТРК нужен как можно скорее
+    pollEscalate(&ctx->poll);
 
     Serial.print("Key pressed: ");
     Serial.println(key);
@@ -704,69 +1061,64 @@ void processKeyFSM(FSMContext* ctx, char key) {
     switch (ctx->state) {
         case FSM_STATE_WAIT_FOR_PRICE_INPUT: {
             if (key >= '0' && key <= '9') {
-                size_t len = strlen(ctx->priceInput);
+                size_t len = strlen(ui.priceInput);
                 if (len < PRICE_FORMAT_LENGTH) {
-                    ctx->priceInput[len] = key;
-                    ctx->priceInput[len + 1] = '\0';
+                    ui.priceInput[len] = key;
+                    ui.priceInput[len + 1] = '\0';
                     char displayStr[32];
                     snprintf(displayStr, sizeof(displayStr), "%s: %s",
-                             ctx->fuelMode == FUEL_BY_VOLUME ? "Volume" : "Amount", ctx->priceInput);
-                    displayMessage(displayStr);
+                             ctx->fuelMode == FUEL_BY_VOLUME ? "Volume" : "Amount", ui.priceInput);
+                    showMessage(ctx, displayStr);
                     Serial.print("Input so far: ");
-                    Serial.println(ctx->priceInput);
+                    Serial.println(ui.priceInput);
                 }
                 ctx->stateEntryTime = currentMillis;
             }
             else if (key == '*') {
-                size_t len = strlen(ctx->priceInput);
-                if (len < PRICE_FORMAT_LENGTH - 1 && strchr(ctx->priceInput, '.') == nullptr) {
-                    ctx->priceInput[len] = '.';
-                    ctx->priceInput[len + 1] = '\0';
+                size_t len = strlen(ui.priceInput);
+                if (len < PRICE_FORMAT_LENGTH - 1 && strchr(ui.priceInput, '.') == nullptr) {
+                    ui.priceInput[len] = '.';
+                    ui.priceInput[len + 1] = '\0';
                     char displayStr[32];
                     snprintf(displayStr, sizeof(displayStr), "%s: %s",
-                             ctx->fuelMode == FUEL_BY_VOLUME ? "Volume" : "Amount", ctx->priceInput);
-                    displayMessage(displayStr);
+                             ctx->fuelMode == FUEL_BY_VOLUME ? "Volume" : "Amount", ui.priceInput);
+                    showMessage(ctx, displayStr);
                     Serial.print("Input so far: ");
-                    Serial.println(ctx->priceInput);
+                    Serial.println(ui.priceInput);
                 }
                 ctx->stateEntryTime = currentMillis;
             }
             else if (key == 'E') {
-                if (strlen(ctx->priceInput) == 0) {
-                    ctx->state = FSM_STATE_IDLE;
-                    ctx->stateEntryTime = currentMillis;
+                if (strlen(ui.priceInput) == 0) {
+                    enterState(ctx, FSM_STATE_IDLE);
                     if (!ctx->nozzleUpWarning) {
-                        if (ctx->modeSelected) {
-                            displayFuelMode(ctx->fuelMode);
-                        } else {
-                            displayMessage("Please select mode");
-                        }
+                        displayIdle(ctx);
                     }
                 } else {
-                    ctx->priceInput[0] = '\0';
-                    displayMessage("Cleared");
+                    ui.priceInput[0] = '\0';
+                    showText(ctx, TEXT_CLEARED);
                     ctx->stateEntryTime = currentMillis;
                 }
             }
             else if (key == 'K') {
-                if (strlen(ctx->priceInput) > 0) {
+                if (strlen(ui.priceInput) > 0) {
                     uint32_t value;
                     if (ctx->fuelMode == FUEL_BY_VOLUME) {
-                        float floatValue = atof(ctx->priceInput);
+                        float floatValue = atof(ui.priceInput);
                         if (floatValue > 0 && floatValue <= 9999.99) {
                             value = (uint32_t)(floatValue * 100);
                         } else {
-                            displayMessage("Invalid volume!");
-                            ctx->priceInput[0] = '\0';
+                            showText(ctx, TEXT_INVALID_VOLUME);
+                            ui.priceInput[0] = '\0';
                             ctx->stateEntryTime = currentMillis;
                             Serial.println("Invalid volume: Out of range");
                             break;
                         }
                     } else {
-                        value = atol(ctx->priceInput);
+                        value = atol(ui.priceInput);
                         if (value == 0) {
-                            displayMessage("Invalid amount!");
-                            ctx->priceInput[0] = '\0';
+                            showText(ctx, TEXT_INVALID_AMOUNT);
+                            ui.priceInput[0] = '\0';
                             ctx->stateEntryTime = currentMillis;
                             Serial.println("Invalid amount: Zero");
                             break;
@@ -774,17 +1126,10 @@ void processKeyFSM(FSMContext* ctx, char key) {
                         Serial.print("Parsed amount: ");
                         Serial.println(value);
                     }
-                    if (ctx->fuelMode == FUEL_BY_VOLUME) {
-                        ctx->transactionVolume = value;
-                        ctx->transactionAmount = 0;
-                    } else {
-                        ctx->transactionVolume = 0;
-                        ctx->transactionAmount = value;
-                    }
-                    ctx->state = FSM_STATE_CONFIRM_TRANSACTION;
-                    ctx->stateEntryTime = currentMillis;
-                    ctx->priceInput[0] = '\0';
-                    displayMessage("Confirm? Press K");
+                    ctx->transactionTarget = value;
+                    enterState(ctx, FSM_STATE_CONFIRM_TRANSACTION);
+                    ui.priceInput[0] = '\0';
+                    showText(ctx, TEXT_CONFIRM_PRESS_K);
                     Serial.print("Confirmed value: ");
                     Serial.println(value);
                 }
@@ -793,66 +1138,61 @@ void processKeyFSM(FSMContext* ctx, char key) {
         }
         case FSM_STATE_IDLE: {
             if (ctx->nozzleUpWarning && key == 'K') {
-                displayMessage("Nozzle up! Hang up");
+                showText(ctx, TEXT_NOZZLE_UP);
                 ctx->stateEntryTime = currentMillis;
             } else if (key == 'G') {
-                ctx->state = FSM_STATE_VIEW_PRICE;
-                ctx->stateEntryTime = currentMillis;
-                char priceStr[16];
-                snprintf(priceStr, sizeof(priceStr), "Price: %u", ctx->price);
-                displayMessage(priceStr);
+                enterState(ctx, FSM_STATE_VIEW_PRICE);
+                displayNozzlePrice(ctx);
+            } else if (key == 'D') {
+                selectNextNozzle(ctx);
+                displayNozzlePrice(ctx);
             } else if (key == 'E') {
                 ctx->statusPollingActive = true;
                 ctx->modeSelected = false;
                 if (!ctx->nozzleUpWarning) {
-                    displayMessage("Please select mode");
+                    showText(ctx, TEXT_SELECT_MODE);
                 }
                 ctx->stateEntryTime = currentMillis;
             } else if (key == 'C') {
                 ctx->fuelMode = (FuelMode)((ctx->fuelMode + 1) % 3);
                 ctx->modeSelected = true;
-                displayFuelMode(ctx->fuelMode);
+                displayFuelMode(ctx);
                 ctx->stateEntryTime = currentMillis;
             } else if (key == 'K' && !ctx->nozzleUpWarning) {
                 if (ctx->fuelMode == FUEL_BY_VOLUME || ctx->fuelMode == FUEL_BY_PRICE) {
-                    ctx->priceInput[0] = '\0';
-                    ctx->state = FSM_STATE_WAIT_FOR_PRICE_INPUT;
-                    displayMessage(ctx->fuelMode == FUEL_BY_VOLUME ? "Enter Volume" : "Enter Amount");
+                    ui.priceInput[0] = '\0';
+                    enterState(ctx, FSM_STATE_WAIT_FOR_PRICE_INPUT);
+                    showText(ctx, ctx->fuelMode == FUEL_BY_VOLUME ? TEXT_ENTER_VOLUME : TEXT_ENTER_AMOUNT);
                 } else {
-                    ctx->transactionVolume = 0;
-                    ctx->transactionAmount = 999999;
-                    ctx->state = FSM_STATE_CONFIRM_TRANSACTION;
-                    ctx->stateEntryTime = currentMillis;
-                    displayMessage("Confirm? Press K");
+                    ctx->transactionTarget = 999999;
+                    enterState(ctx, FSM_STATE_CONFIRM_TRANSACTION);
+                    showText(ctx, TEXT_CONFIRM_PRESS_K);
                 }
             } else if (key == 'A') {
                 ctx->statusPollingActive = false;
-                ctx->state = FSM_STATE_TOTAL_COUNTER;
-                ctx->stateEntryTime = currentMillis;
+                enterState(ctx, FSM_STATE_TOTAL_COUNTER);
                 ctx->errorCount = 0;
-                ctx->c0RetryCount = 0;
-                ctx->waitingForResponse = true;
-                ctx->lastC0SendTime = currentMillis;
-                rs422SendTotalCounter();
-                displayMessage("TOTAL:\nWaiting...");
+                // Показания прошлого цикла не выдаются за текущие
+                for (uint8_t i = 0; i < NOZZLE_COUNT; i++) ctx->nozzles[i].totalizer_mL = TOTALIZER_UNKNOWN;
+                ctx->totalNozzle = 1;
+                ctx->waitingForResponse = PumpDriver::readTotalizer(ctx->address, ctx->totalNozzle, onTotalCounterReply, ctx);
+                showText(ctx, TEXT_TOTAL_WAITING);
             }
             break;
         }
         case FSM_STATE_VIEW_PRICE: {
-            if (key == 'G') {
-                ctx->state = FSM_STATE_EDIT_PRICE;
+            if (key == 'D') {
+                selectNextNozzle(ctx);
                 ctx->stateEntryTime = currentMillis;
-                ctx->priceInput[0] = '\0';
-                displayMessage("Editing Price");
+                displayNozzlePrice(ctx);
+            } else if (key == 'G') {
+                enterState(ctx, FSM_STATE_EDIT_PRICE);
+                ui.priceInput[0] = '\0';
+                showText(ctx, TEXT_EDITING_PRICE);
             } else if (key == 'E') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
+                enterState(ctx, FSM_STATE_IDLE);
                 if (!ctx->nozzleUpWarning) {
-                    if (ctx->modeSelected) {
-                        displayFuelMode(ctx->fuelMode);
-                    } else {
-                        displayMessage("Please select mode");
-                    }
+                    displayIdle(ctx);
                 }
             }
             break;
@@ -860,39 +1200,34 @@ void processKeyFSM(FSMContext* ctx, char key) {
         case FSM_STATE_EDIT_PRICE: {
             ctx->stateEntryTime = currentMillis;
             if (key >= '0' && key <= '9') {
-                size_t len = strlen(ctx->priceInput);
+                size_t len = strlen(ui.priceInput);
                 if (len < PRICE_FORMAT_LENGTH) {
-                    ctx->priceInput[len] = key;
-                    ctx->priceInput[len + 1] = '\0';
+                    ui.priceInput[len] = key;
+                    ui.priceInput[len + 1] = '\0';
                     char displayStr[32];
-                    snprintf(displayStr, sizeof(displayStr), "New Price: %s", ctx->priceInput);
-                    displayMessage(displayStr);
+                    snprintf(displayStr, sizeof(displayStr), "New Price: %s", ui.priceInput);
+                    showMessage(ctx, displayStr);
                 }
             } else if (key == 'E') {
-                ctx->priceInput[0] = '\0';
-                displayMessage("Price cleared");
+                ui.priceInput[0] = '\0';
+                showText(ctx, TEXT_PRICE_CLEARED);
             } else if (key == 'K') {
-                if (strlen(ctx->priceInput) > 0) {
-                    uint16_t newPrice = atol(ctx->priceInput);
+                if (strlen(ui.priceInput) > 0) {
+                    uint16_t newPrice = atol(ui.priceInput);
                     if (newPrice >= PRICE_MIN && newPrice <= 99999) {
-                        ctx->price = newPrice;
-                        writePriceToEEPROM(ctx->price);
-                        displayMessage("Price updated!");
-                        ctx->state = FSM_STATE_TRANSITION_EDIT_PRICE;
-                        ctx->stateEntryTime = currentMillis;
-                        ctx->priceInput[0] = '\0';
+                        ctx->nozzles[ctx->selectedNozzle - 1].price = newPrice;
+                        writePriceToEEPROM(ctx->post, ctx->selectedNozzle, newPrice);
+                        showText(ctx, TEXT_PRICE_UPDATED);
+                        enterState(ctx, FSM_STATE_TRANSITION_EDIT_PRICE);
+                        ui.priceInput[0] = '\0';
                     } else {
-                        displayMessage("Price too high! Max");
-                        ctx->priceInput[0] = '\0';
+                        showText(ctx, TEXT_PRICE_TOO_HIGH);
+                        ui.priceInput[0] = '\0';
                     }
                 } else {
-                    ctx->state = FSM_STATE_IDLE;
+                    enterState(ctx, FSM_STATE_IDLE);
                     if (!ctx->nozzleUpWarning) {
-                        if (ctx->modeSelected) {
-                            displayFuelMode(ctx->fuelMode);
-                        } else {
-                            displayMessage("Please select mode");
-                        }
+                        displayIdle(ctx);
                     }
                     ctx->stateEntryTime = currentMillis;
                 }
@@ -901,149 +1236,114 @@ void processKeyFSM(FSMContext* ctx, char key) {
         }
         case FSM_STATE_TRANSITION_PRICE_SET:
         case FSM_STATE_TRANSITION_EDIT_PRICE: {
-            if (currentMillis - ctx->stateEntryTime >= TRANSITION_TIMEOUT) {
+            if (elapsed(currentMillis, ctx->stateEntryTime) >= TRANSITION_TIMEOUT) {
                 ctx->waitingForResponse = false;
-                ctx->state = (ctx->state == FSM_STATE_TRANSITION_PRICE_SET) ? FSM_STATE_CHECK_STATUS : FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
+                enterState(ctx, ctx->state == FSM_STATE_TRANSITION_PRICE_SET ? FSM_STATE_CHECK_STATUS : FSM_STATE_IDLE);
                 if (ctx->state == FSM_STATE_IDLE && !ctx->nozzleUpWarning) {
-                    if (ctx->modeSelected) {
-                        displayFuelMode(ctx->fuelMode);
-                    } else {
-                        displayMessage("Please select mode");
-                    }
+                    displayIdle(ctx);
                 }
             }
             break;
         }
         case FSM_STATE_CONFIRM_TRANSACTION: {
             if (key == 'K') {
-                ctx->state = FSM_STATE_TRANSACTION;
-                ctx->stateEntryTime = currentMillis;
-                displayMessage("Confirm! UP Nozzle");
+                enterState(ctx, FSM_STATE_TRANSACTION);
+                showText(ctx, TEXT_CONFIRM_UP_NOZZLE);
                 Serial.println("Transaction confirmed");
             } else if (key == 'E') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
-                ctx->transactionVolume = 0;
-                ctx->transactionAmount = 0;
+                enterState(ctx, FSM_STATE_IDLE);
+                ctx->transactionTarget = 0;
                 ctx->nozzleUpWarning = false;
                 ctx->waitingForResponse = false;
                 ctx->errorCount = 0;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
+                displayIdle(ctx);
                 Serial.println("Confirm cancelled, returning to idle");
             }
             break;
         }
         case FSM_STATE_TRANSACTION: {
             if (key == 'E' && !ctx->transactionStarted) {
-                rs422SendNozzleOff();
+                // Шина не приняла команду даже в резерве срочных: состояние не меняется, клавишу можно нажать снова
+                if (!PumpDriver::stop(ctx->address, onControlDelivered, ctx)) {
+                    showToast(ctx, TEXT_STOP_PAUSE_FAILED);
+                    break;
+                }
+                ctx->stopUnconfirmed = true;
                 ctx->waitingForResponse = false;
                 ctx->statusPollingActive = false;
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
+                enterState(ctx, FSM_STATE_IDLE);
                 ctx->transactionStarted = false;
-                ctx->monitorState = 0;
                 ctx->monitorActive = false;
                 ctx->currentLiters_dL = 0;
                 ctx->currentPriceTotal = 0;
-                ctx->finalLiters_dL = 0;
-                ctx->finalPriceTotal = 0;
                 ctx->errorCount = 0;
                 ctx->nozzleUpWarning = false;
                 ctx->skipFirstStatusCheck = true;
-                ctx->transactionVolume = 0;
-                ctx->transactionAmount = 0;
-                rs422SendNozzleOff();
-                delay(100);
+                ctx->transactionTarget = 0;
                 ctx->statusPollingActive = true;
-                rs422SendStatus();
+                requestStatus(ctx, onIdleReply);
                 if (!ctx->nozzleUpWarning) {
-                    if (ctx->modeSelected) {
-                        displayFuelMode(ctx->fuelMode);
-                    } else {
-                        displayMessage("Please select mode");
-                    }
+                    displayIdle(ctx);
                 }
                 Serial.println("Transaction cancelled, returning to idle");
             } else if (key == 'E') {
-                rs422SendPause();
-                ctx->waitingForResponse = true;
-                ctx->state = FSM_STATE_TRANSACTION_PAUSED;
-                ctx->stateEntryTime = currentMillis;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Paused", ctx->price > 9999);
-                saveTransactionState(ctx->currentLiters_dL, ctx->currentPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+                if (!PumpDriver::pause(ctx->address, onControlDelivered, ctx)) {
+                    showToast(ctx, TEXT_STOP_PAUSE_FAILED);
+                    break;
+                }
+                enterState(ctx, FSM_STATE_TRANSACTION_PAUSED);
+                ctx->pauseUnconfirmed = true;
                 Serial.println("Transaction paused");
             }
             break;
         }
         case FSM_STATE_TRANSACTION_PAUSED: {
             if (key == 'K') {
-                rs422SendResume();
-                ctx->waitingForResponse = true;
-                ctx->state = FSM_STATE_TRANSACTION;
-                ctx->stateEntryTime = currentMillis;
+                // Очередь шины занята: пауза остаётся, клавишу можно нажать снова
+                if (!PumpDriver::resume(ctx->address)) {
+                    showToast(ctx, TEXT_SLOW_DOWN);
+                    break;
+                }
+                enterState(ctx, FSM_STATE_TRANSACTION);
                 ctx->monitorActive = true;
-                ctx->monitorState = 0;
-                displayTransaction(ctx->currentLiters_dL, ctx->currentPriceTotal, "Dispensing...", ctx->price > 9999);
+                displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
                 Serial.println("Transaction resumed");
             } else if (key == 'E') {
-                ctx->finalLiters_dL = ctx->currentLiters_dL;
-                ctx->finalPriceTotal = ctx->currentPriceTotal;
-                rs422SendTransactionUpdate();
-                ctx->waitingForResponse = true;
-                ctx->state = FSM_STATE_TRANSACTION_END;
-                ctx->stateEntryTime = currentMillis;
-                saveTransactionState(ctx->finalLiters_dL, ctx->finalPriceTotal, ctx->state, ctx->fuelMode, ctx->modeSelected);
+                enterState(ctx, FSM_STATE_TRANSACTION_END);
                 Serial.println("Transaction ended from paused");
             }
             break;
         }
         case FSM_STATE_TRANSACTION_END: {
             if (key == 'E') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
+                enterState(ctx, FSM_STATE_IDLE);
                 ctx->transactionStarted = false;
-                ctx->monitorState = 0;
                 ctx->monitorActive = false;
                 ctx->waitingForResponse = false;
                 ctx->currentLiters_dL = 0;
                 ctx->currentPriceTotal = 0;
-                ctx->finalLiters_dL = 0;
-                ctx->finalPriceTotal = 0;
                 ctx->errorCount = 0;
                 ctx->skipFirstStatusCheck = true;
                 ctx->nozzleUpWarning = false;
-                ctx->transactionVolume = 0;
-                ctx->transactionAmount = 0;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
+                ctx->transactionTarget = 0;
+                displayIdle(ctx);
                 Serial.println("Transaction end, returning to idle");
             }
             break;
         }
         case FSM_STATE_TOTAL_COUNTER: {
-            if (key == 'E') {
-                ctx->state = FSM_STATE_IDLE;
-                ctx->stateEntryTime = currentMillis;
+            if (key == 'D') {
+                selectNextNozzle(ctx);
+                displayTotal(ctx);
+            } else if (key == 'E') {
+                enterState(ctx, FSM_STATE_IDLE);
                 ctx->transactionStarted = false;
-                ctx->monitorState = 0;
                 ctx->monitorActive = false;
                 ctx->waitingForResponse = false;
                 ctx->errorCount = 0;
-                ctx->c0RetryCount = 0;
+                ctx->totalNozzle = 0;
                 ctx->nozzleUpWarning = false;
-                if (ctx->modeSelected) {
-                    displayFuelMode(ctx->fuelMode);
-                } else {
-                    displayMessage("Please select mode");
-                }
+                displayIdle(ctx);
                 Serial.println("Total counter cancelled, returning to idle");
             }
             break;
@@ -1052,6 +1352,60 @@ void processKeyFSM(FSMContext* ctx, char key) {
     }
 }
 
+/* Переключение дисплея и клавиатуры на другой пост */
+void fsmAttachDisplay(FSMContext* ctx) {
+    displayOwner = ctx;
+    ui.priceInput[0] = '\0';
+    switch (ctx->state) {
+        case FSM_STATE_TRANSACTION:
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_DISPENSING);
+            break;
+        case FSM_STATE_TRANSACTION_PAUSED:
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_PAUSED);
+            break;
+        case FSM_STATE_TRANSACTION_END:
+            displayTransaction(ctx, ctx->currentLiters_dL, ctx->currentPriceTotal, TEXT_FILLING_END);
+            break;
+        case FSM_STATE_ERROR:
+            showText(ctx, TEXT_PUMP_OFFLINE);
+            break;
+        case FSM_STATE_IDLE:
+            displayIdle(ctx);
+            break;
+        default: {
+            char postStr[16];
+            snprintf(postStr, sizeof(postStr), "Post %u", ctx->address);
+            showMessage(ctx, postStr);
+            break;
+        }
+    }
+}
+
+void fsmReportStats() {
+    Serial.print("Recovery: ");
+    Serial.print(recovery.recoveries);
+    Serial.print(" times, last outage=");
+    Serial.print(recovery.lastOutage);
+    Serial.print(" ms (max ");
+    Serial.print(recovery.maxOutage);
+    Serial.print("), last resync=");
+    Serial.print(recovery.lastResync);
+    Serial.print(" ms (max ");
+    Serial.print(recovery.maxResync);
+    Serial.println(")");
+    // Переходы по статусу: номер действия (StatusActionId), число и наибольшее время
+    for (uint8_t i = 0; i < STATUS_ACT_COUNT; i++) {
+        if (transitionTiming[i].count == 0) continue;
+        Serial.print("Transition ");
+        Serial.print(i);
+        Serial.print(": n=");
+        Serial.print(transitionTiming[i].count);
+        Serial.print(", max ");
+        Serial.print(transitionTiming[i].maxMicros);
+        Serial.println(" us");
+    }
+}
+
 /* Получение состояния FSM */
 FSMState getCurrentState(const FSMContext* ctx) {
     return ctx->state;
@@ -4,14 +4,15 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "poll.h"
 
-typedef enum {
+typedef enum : uint8_t {
     FUEL_BY_VOLUME,
     FUEL_BY_PRICE,
     FUEL_BY_FULL_TANK
 } FuelMode;
 
-typedef enum {
+typedef enum : uint8_t {
     FSM_STATE_CHECK_STATUS,
     FSM_STATE_IDLE,
     FSM_STATE_WAIT_FOR_PRICE_INPUT,
@@ -24,39 +25,76 @@ typedef enum {
     FSM_STATE_TRANSACTION_END,
     FSM_STATE_TOTAL_COUNTER,
     FSM_STATE_TRANSACTION_PAUSED,
-    FSM_STATE_CONFIRM_TRANSACTION
+    FSM_STATE_CONFIRM_TRANSACTION,
+    FSM_STATE_COUNT
 } FSMState;
 
+#define TOTALIZER_UNKNOWN 0xFFFFFFFFUL // Счётчик рукава не прочитан (в ответе C не больше 9 цифр)
+
+// Данные рукава поста
+struct NozzleState {
+    uint16_t price;
+    uint32_t totalizer_mL;      // Показание суммарного счётчика (команда C), TOTALIZER_UNKNOWN — нет показания
+    uint32_t lastLiters_dL;     // Последняя завершённая транзакция (команда T)
+    uint32_t lastAmount;
+};
+
+/**
+ * Per-post automaton state. Fields the bus and FSM touch every poll come
+ * first and are kept narrow: flags are single bits, counters are bytes,
+ * timestamps are the low 16 bits of millis() (intervals up to 65 s).
+ * The nozzle table follows; keypad input lives in one shared UI state.
+ */
 struct FSMContext {
+    uint8_t post;               // Индекс поста (слот EEPROM)
+    uint8_t address;            // Адрес поста на шине (1-32)
     FSMState state;
     FuelMode fuelMode;
-    uint16_t price;
-    bool priceValid;
-    uint32_t transactionVolume;
-    uint32_t transactionAmount;
-    bool transactionStarted;
-    bool waitingForResponse;
-    int errorCount;
-    int c0RetryCount;
-    bool statusPollingActive;
-    int monitorState;
-    bool monitorActive;
-    uint32_t currentLiters_dL;
-    uint32_t finalLiters_dL;
+    uint8_t selectedNozzle : 4; // Рукав для просмотра цены и счётчиков (1..NOZZLE_COUNT)
+    uint8_t activeNozzle : 4;   // Рукав из статуса ТРК (0 — не снят)
+    uint8_t totalNozzle : 4;    // Рукав текущего запроса C в цикле счётчиков
+    bool priceValid : 1;
+    bool transactionStarted : 1;
+    bool waitingForResponse : 1;
+    bool statusPollingActive : 1;
+    bool monitorActive : 1;
+    bool nozzleUpWarning : 1;
+    bool transactionDataReceived : 1;
+    bool skipFirstStatusCheck : 1;
+    bool modeSelected : 1;
+    bool pauseUnconfirmed : 1;  // Команда B отправлена, статус паузы от ТРК ещё не пришёл
+    bool stopUnconfirmed : 1;   // Команда N отправлена, ТРК ещё может быть в разрешении налива
+    bool nozzleOffPending : 1;  // Команда N не встала в очередь шины и повторится
+    uint8_t errorCount;         // Нераспознанных ответов подряд
+    uint8_t probeStep;          // Удвоений периода пробного опроса в режиме восстановления
+    uint8_t resyncStatus;       // Код статуса, по которому читаются T и L после восстановления (0 — нет)
+    uint32_t transactionTarget; // Заказ: объём (0.01 л) или сумма — по fuelMode
+    uint32_t currentLiters_dL;  // Налив текущей (после T — завершённой) транзакции
     uint32_t currentPriceTotal;
-    uint32_t finalPriceTotal;
-    bool nozzleUpWarning;
-    unsigned long stateEntryTime;
-    unsigned long lastKeyTime;
-    unsigned long lastC0SendTime;
-    bool skipFirstStatusCheck;
-    char priceInput[PRICE_FORMAT_LENGTH + 1];
-    bool modeSelected;
+    uint16_t stateEntryTime;
+    uint16_t nozzleUpStartTime;
+    unsigned long offlineSince; // Начало потери связи (для времени восстановления)
+    PollScheduler poll;
+    NozzleState nozzles[NOZZLE_COUNT];
 };
 
-void initFSM(FSMContext* ctx);
+#ifdef __AVR__
+// Бюджет ОЗУ на пост: при POST_COUNT = 32 все контексты должны уместиться в 8 КБ вместе со стеком и буферами
+static_assert(offsetof(FSMContext, nozzles) <= FSM_HOT_STATE_BUDGET, "FSMContext hot state exceeds its byte budget");
+static_assert(sizeof(FSMContext) <= FSM_HOT_STATE_BUDGET + NOZZLE_COUNT * sizeof(NozzleState),
+              "FSMContext exceeds its per-post byte budget");
+#endif
+
+void initFSM(FSMContext* ctx, uint8_t post);
 void updateFSM(FSMContext* ctx);
 void processKeyFSM(FSMContext* ctx, char key);
+void fsmAttachDisplay(FSMContext* ctx);
+
+/**
+ * Prints recovery statistics (outage and resync time of posts that came
+ * back online) and per-transition timing of status dispatch to the debug port.
+ */
+void fsmReportStats();
 FSMState getCurrentState(const FSMContext* ctx);
 FuelMode getCurrentFuelMode(const FSMContext* ctx);
 
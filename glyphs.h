@@ -0,0 +1,23 @@
+// glyphs.h
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+#include <Arduino.h>
+
+// Крупные цифры экрана налива: три строки тайлов (24 пикселя) в формате буфера SSD1306
+#define FIGURE_TILE_ROWS 3
+#define FIGURE_DIGIT_WIDTH 16   // Ширина цифры и пробела (пикселей, два тайла)
+#define FIGURE_POINT_WIDTH 8    // Ширина десятичной точки (один тайл)
+
+/**
+ * Pre-rasterised seven-segment digits 0-9: for each tile row, one byte
+ * per pixel column, bit 0 at the top, as in the U8g2 SSD1306 buffer.
+ */
+extern const uint8_t figureDigits[10][FIGURE_TILE_ROWS][FIGURE_DIGIT_WIDTH] PROGMEM;
+
+/**
+ * Decimal point in the same layout, aligned with the bottom of the digits.
+ */
+extern const uint8_t figurePoint[FIGURE_TILE_ROWS][FIGURE_POINT_WIDTH] PROGMEM;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+// message.cpp
+#include "message.h"
+
+uint8_t messageReplyLength(const uint8_t* frame, uint8_t count) {
+    switch (frame[FRAME_COMMAND_OFFSET]) {
+        case 'S': return StatusMessage::length;
+        case 'L':
+        case 'R': return MonitorMessage::length;
+        case 'C': return TotalCounterMessage::length;
+        case 'T':
+            if (count <= TransactionEndMessage::Flag::offset) return 0;
+            return TransactionEndReply(frame).extended() ? TransactionEndMessage::length
+                                                         : TransactionEndShortMessage::length;
+        default: return 0;
+    }
+}
+
+bool TransactionEndReply::totals(uint32_t* liters, uint32_t* amount) const {
+    uint32_t parsedLiters, parsedAmount;
+    bool valid = extended()
+        ? readField<TransactionEndMessage::Amount>(frame, &parsedAmount) &&
+          readField<TransactionEndMessage::Liters>(frame, &parsedLiters)
+        : readField<TransactionEndShortMessage::Amount>(frame, &parsedAmount) &&
+          readField<TransactionEndShortMessage::Liters>(frame, &parsedLiters);
+    if (!valid) return false;
+    *liters = parsedLiters;
+    *amount = parsedAmount;
+    return true;
+}
+
+// Поле запроса в буфере данных: смещение считается от начала данных, а не от STX
+template <typename Field>
+static uint8_t* payloadField(uint8_t* payload) {
+    return payload + Field::offset - FRAME_PAYLOAD_OFFSET;
+}
+
+uint8_t encodeTotalCounter(uint8_t* payload, uint8_t nozzle) {
+    *payloadField<TotalCounterRequest::Nozzle>(payload) = '0' + nozzle;
+    return TotalCounterRequest::payloadLength;
+}
+
+uint8_t encodePreset(uint8_t* payload, uint8_t nozzle, uint32_t quantity, uint16_t price) {
+    typedef PresetRequest::Quantity Quantity;
+    typedef PresetRequest::Price Price;
+    if (quantity > PRESET_FULL_TANK) quantity = PRESET_FULL_TANK;
+    *payloadField<PresetRequest::Nozzle>(payload) = '0' + nozzle;
+    // formatPadded дописывает NUL за полем: поля идут по порядку, разделитель ставится после числа перед ним
+    formatPadded((char*)payloadField<Quantity>(payload), quantity, Quantity::width);
+    formatPadded((char*)payloadField<Price>(payload), price, Price::width);
+    payloadField<Quantity>(payload)[-1] = ';';
+    payloadField<Price>(payload)[-1] = ';';
+    return PresetRequest::payloadLength;
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+// message.h
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "utils.h"
+
+/* Схема сообщений GasKitLink: смещения полей от STX заданы один раз при компиляции */
+
+// Заголовок любого кадра: STX, два байта адреса, команда; данные идут следом
+#define FRAME_COMMAND_OFFSET 3
+#define FRAME_PAYLOAD_OFFSET 4
+
+/**
+ * Fixed-width field of a frame. Offsets count from STX; a field placed
+ * after another one is declared from that field's end, so a layout
+ * change moves every field behind it.
+ */
+template <uint8_t Offset, uint8_t Width>
+struct MessageField {
+    static constexpr uint8_t offset = Offset;
+    static constexpr uint8_t width = Width;
+    static constexpr uint8_t end = Offset + Width;
+};
+
+/**
+ * Frame of a command: total length from STX through CRC. The CRC is the
+ * last byte, so every field has to end at or before it.
+ */
+template <char Command, uint8_t Length>
+struct MessageFrame {
+    static constexpr char command = Command;
+    static constexpr uint8_t length = Length;
+    static constexpr uint8_t crc = Length - 1;
+    static constexpr uint8_t payloadLength = Length - FRAME_PAYLOAD_OFFSET - 1;
+};
+
+// Поле умещается в кадр до байта CRC
+template <typename Frame, typename Field>
+constexpr bool fieldFits() {
+    return Field::offset >= FRAME_PAYLOAD_OFFSET && Field::end <= Frame::crc;
+}
+
+/* Запросы */
+
+// S, T, L, R без данных: кадр целиком лежит во флеш-памяти (frame.h)
+typedef MessageFrame<'S', 5> StatusRequest;
+
+// C: цифра рукава
+struct TotalCounterRequest : MessageFrame<'C', 6> {
+    typedef MessageField<4, 1> Nozzle;
+};
+
+// V (объём) и M (сумма): рукав;заказ;цена
+struct PresetRequest : MessageFrame<'V', 18> {
+    typedef MessageField<4, 1> Nozzle;
+    typedef MessageField<Nozzle::end + 1, 6> Quantity;
+    typedef MessageField<Quantity::end + 1, 4> Price;
+};
+
+/* Ответы */
+
+struct StatusMessage : MessageFrame<'S', STATUS_RESPONSE_LENGTH> {
+    typedef MessageField<4, 1> Code;
+    typedef MessageField<Code::end, 1> Nozzle;
+};
+
+// Ответы L (литры налива) и R (сумма налива)
+struct MonitorMessage : MessageFrame<'L', MONITOR_RESPONSE_LENGTH> {
+    typedef MessageField<4, 1> Nozzle;
+    typedef MessageField<8, 6> Value;
+};
+
+// T с флагом 'u': сумма и литры через разделитель
+struct TransactionEndMessage : MessageFrame<'T', TRANSACTION_END_RESPONSE_LENGTH> {
+    typedef MessageField<4, 1> Nozzle;
+    typedef MessageField<Nozzle::end, 1> Flag;
+    typedef MessageField<10, 6> Amount;
+    typedef MessageField<Amount::end + 1, 6> Liters;
+};
+
+// T без флага: сумма и литры сразу за номером рукава, без разделителя
+struct TransactionEndShortMessage : MessageFrame<'T', TRANSACTION_END_SHORT_RESPONSE_LENGTH> {
+    typedef MessageField<4, 1> Nozzle;
+    typedef MessageField<Nozzle::end, 6> Amount;
+    typedef MessageField<Amount::end, 6> Liters;
+};
+
+struct TotalCounterMessage : MessageFrame<'C', TOTAL_COUNTER_RESPONSE_LENGTH> {
+    typedef MessageField<4, 1> Nozzle;
+    typedef MessageField<Nozzle::end + 1, 9> Total;
+};
+
+static_assert(fieldFits<TotalCounterRequest, TotalCounterRequest::Nozzle>(), "C request layout");
+static_assert(fieldFits<PresetRequest, PresetRequest::Price>(), "V/M request layout");
+static_assert(PresetRequest::payloadLength < MAX_FRAME_PAYLOAD, "V/M payload exceeds MAX_FRAME_PAYLOAD");
+static_assert(fieldFits<StatusMessage, StatusMessage::Nozzle>(), "S reply layout");
+static_assert(fieldFits<MonitorMessage, MonitorMessage::Value>(), "L/R reply layout");
+static_assert(fieldFits<TransactionEndMessage, TransactionEndMessage::Liters>(), "T reply layout");
+static_assert(fieldFits<TransactionEndShortMessage, TransactionEndShortMessage::Liters>(), "short T reply layout");
+static_assert(fieldFits<TotalCounterMessage, TotalCounterMessage::Total>(), "C reply layout");
+static_assert(TransactionEndMessage::length <= MAX_FRAME_LENGTH, "T reply exceeds MAX_FRAME_LENGTH");
+
+/**
+ * Parses a numeric field in place (see parseFixedDecimal).
+ * @param frame Received frame.
+ * @param value Output value; written only on success.
+ * @return false if the field holds a non-digit.
+ */
+template <typename Field>
+bool readField(const uint8_t* frame, uint32_t* value) {
+    return parseFixedDecimal(frame + Field::offset, Field::width, value);
+}
+
+/* Типизированные представления принятого кадра: читают поля прямо из буфера декодера, без копий */
+
+/**
+ * Read-only view of a received frame. Views do not own or copy the
+ * buffer and are valid only while the reply callback runs.
+ */
+struct ReplyView {
+    const uint8_t* frame;
+
+    explicit ReplyView(const uint8_t* frame) : frame(frame) {}
+    char command() const { return frame[FRAME_COMMAND_OFFSET]; }
+};
+
+// Ответ S: код статуса '1'..'9' и цифра рукава ('0' — рукав не снят)
+struct StatusReply : ReplyView {
+    explicit StatusReply(const uint8_t* frame) : ReplyView(frame) {}
+    static bool complete(int length) { return length >= StatusMessage::length; }
+    char code() const { return frame[StatusMessage::Code::offset]; }
+    uint8_t nozzleDigit() const { return frame[StatusMessage::Nozzle::offset]; }
+    bool nozzleUp() const { return nozzleDigit() != '0'; }
+    // Код и рукав подряд, два байта (для сравнения статусов)
+    const uint8_t* codeBytes() const { return frame + StatusMessage::Code::offset; }
+};
+
+// Ответы L и R: рукав и значение налива (литры или сумма)
+struct MonitorReply : ReplyView {
+    explicit MonitorReply(const uint8_t* frame) : ReplyView(frame) {}
+    static bool complete(int length) { return length >= MonitorMessage::length; }
+    uint8_t nozzleDigit() const { return frame[MonitorMessage::Nozzle::offset]; }
+    bool value(uint32_t* value) const { return readField<MonitorMessage::Value>(frame, value); }
+};
+
+// Ответ T: итоги транзакции; раскладка полей зависит от флага 'u'
+struct TransactionEndReply : ReplyView {
+    explicit TransactionEndReply(const uint8_t* frame) : ReplyView(frame) {}
+    static bool complete(int length) { return length >= TransactionEndShortMessage::length; }
+    uint8_t nozzleDigit() const { return frame[TransactionEndMessage::Nozzle::offset]; }
+    bool extended() const { return frame[TransactionEndMessage::Flag::offset] == 'u'; }
+    bool totals(uint32_t* liters, uint32_t* amount) const;
+};
+
+// Ответ C: рукав и показание суммарного счётчика (мл)
+struct TotalCounterReply : ReplyView {
+    explicit TotalCounterReply(const uint8_t* frame) : ReplyView(frame) {}
+    static bool complete(int length) { return length >= TotalCounterMessage::length; }
+    uint8_t nozzleDigit() const { return frame[TotalCounterMessage::Nozzle::offset]; }
+    bool total(uint32_t* value) const { return readField<TotalCounterMessage::Total>(frame, value); }
+};
+
+/**
+ * Returns the full length of a reply from its header, as the frame
+ * decoder needs it (T is known only once its flag byte has arrived).
+ * @param frame Bytes received so far.
+ * @param count Number of bytes received.
+ * @return Frame length, or 0 if unknown yet or not fixed by the protocol.
+ */
+uint8_t messageReplyLength(const uint8_t* frame, uint8_t count);
+
+/* Кодировщики запросов: пишут данные прямо в буфер запроса очереди RS422 */
+
+/**
+ * Writes the payload of a C request.
+ * @param payload Output buffer (TotalCounterRequest::payloadLength bytes).
+ * @param nozzle Nozzle number (1-9).
+ * @return Payload length.
+ */
+uint8_t encodeTotalCounter(uint8_t* payload, uint8_t nozzle);
+
+/**
+ * Writes the payload of a V/M preset: nozzle, order and unit price as
+ * fixed-width digits. The order is clamped to the field, so the largest
+ * value (all nines) means "full tank".
+ * @param payload Output buffer (PresetRequest::payloadLength + 1 bytes).
+ * @param nozzle Nozzle number (1-9).
+ * @param quantity Order: volume (0.01 l) or amount.
+ * @param price Unit price (up to 9999).
+ * @return Payload length.
+ */
+uint8_t encodePreset(uint8_t* payload, uint8_t nozzle, uint32_t quantity, uint16_t price);
+
+// Наибольшее значение поля из width цифр
+constexpr uint32_t fieldMaxValue(uint8_t width) {
+    return width ? fieldMaxValue(width - 1) * 10 + 9 : 0;
+}
+
+// Заказ «полный бак» — все девятки в поле заказа
+#define PRESET_FULL_TANK fieldMaxValue(PresetRequest::Quantity::width)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,246 @@
+// mockpump.cpp
+#include "mockpump.h"
+
+#define MOCK_QUEUE_SIZE RS422_QUEUE_SIZE
+
+// Состояние имитируемой ТРК поста
+struct MockPost {
+    char code;                  // Код статуса '1'..'9'
+    uint8_t nozzle;             // Снятый рукав (0 — все на месте)
+    uint8_t saleNozzle;         // Рукав последнего налива (для L, R, T)
+    FuelMode mode;
+    uint16_t price;
+    uint32_t target;            // Заказ: объём (0.01 л) или сумма
+    uint32_t liters;            // Налито (0.01 л)
+    uint16_t flowCredit;        // Остаток от деления при пересчёте налива
+    unsigned long lastFlow;
+    uint32_t totalizer_mL[NOZZLE_COUNT];
+};
+
+// Запрос, ответ на который ещё не выдан
+struct MockRequest {
+    uint8_t address;
+    char command;
+    uint8_t nozzle;             // C: номер рукава
+    unsigned long due;
+    Rs422Callback callback;
+    void* context;
+};
+
+static MockPost posts[POST_COUNT];
+static MockRequest pending[MOCK_QUEUE_SIZE];
+static uint8_t pendingCount = 0;
+static MockReply reply;
+static uint32_t replies = 0;
+static uint8_t consolePost = 0;
+
+static MockPost* findPost(uint8_t address) {
+    for (uint8_t i = 0; i < POST_COUNT; i++) {
+        if (POST_ADDRESSES[i] == address) return &posts[i];
+    }
+    return nullptr;
+}
+
+static uint32_t amountOf(const MockPost* post) {
+    return post->liters * post->price / 100;
+}
+
+// Налив идёт со скоростью MOCK_FLOW_RATE до заказа
+static void flow(MockPost* post, unsigned long now) {
+    unsigned long spent = now - post->lastFlow;
+    post->lastFlow = now;
+    if (post->code != '6') return;
+    uint32_t credit = post->flowCredit + spent * MOCK_FLOW_RATE;
+    uint32_t delta = credit / 1000;
+    post->flowCredit = credit % 1000;
+    post->liters += delta;
+    post->totalizer_mL[post->saleNozzle - 1] += delta * 10;
+    uint32_t done = post->mode == FUEL_BY_VOLUME ? post->liters : amountOf(post);
+    if (done >= post->target) post->code = '8';
+}
+
+static bool submit(uint8_t address, char command, uint8_t nozzle, Rs422Callback callback, void* context) {
+    if (pendingCount >= MOCK_QUEUE_SIZE) return false;
+    MockRequest* request = &pending[pendingCount++];
+    request->address = address;
+    request->command = command;
+    request->nozzle = nozzle;
+    request->due = millis() + MOCK_REPLY_DELAY;
+    request->callback = callback;
+    request->context = context;
+    return true;
+}
+
+// Управляющая команда исполняется, когда «доходит» до ТРК
+static void control(MockPost* post, char command) {
+    switch (command) {
+        case 'N':
+            if (post->code == '6' || post->code == '7') {
+                post->code = '8';
+            } else if (post->code == '8' || post->code == '9') {
+                post->code = post->nozzle ? '2' : '1';
+            }
+            break;
+        case 'B':
+            if (post->code == '6') post->code = '7';
+            break;
+        case 'G':
+            if (post->code == '7') post->code = '6';
+            break;
+    }
+}
+
+static void deliver(const MockRequest* request) {
+    MockPost* post = findPost(request->address);
+    if (!post) {
+        if (request->callback) request->callback(request->context, RS422_RX_TIMEOUT, nullptr, 0);
+        return;
+    }
+    reply.command = request->command;
+    reply.code = post->code;
+    reply.nozzle = '0' + post->nozzle;
+    reply.value = 0;
+    reply.amount = 0;
+    if (request->command == 'L' || request->command == 'R' || request->command == 'T') {
+        reply.nozzle = '0' + post->saleNozzle;
+    }
+    switch (request->command) {
+        case 'L': reply.value = post->liters; break;
+        case 'R': reply.value = amountOf(post); break;
+        case 'T':
+            reply.value = post->liters;
+            reply.amount = amountOf(post);
+            break;
+        case 'C':
+            reply.nozzle = '0' + request->nozzle;
+            reply.value = post->totalizer_mL[request->nozzle - 1];
+            break;
+        case 'S':
+            break;
+        default:
+            control(post, request->command);
+            reply.command = 0;
+            break;
+    }
+    replies++;
+    if (request->callback) request->callback(request->context, RS422_RX_READY, (const uint8_t*)&reply, sizeof(reply));
+}
+
+void MockDriver::init() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < POST_COUNT; i++) {
+        memset(&posts[i], 0, sizeof(MockPost));
+        posts[i].code = '1';
+        posts[i].lastFlow = now;
+    }
+    pendingCount = 0;
+}
+
+void MockDriver::service() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < POST_COUNT; i++) {
+        flow(&posts[i], now);
+    }
+    // Колбэк может поставить новый запрос: запись снимается с очереди до вызова
+    uint8_t i = 0;
+    while (i < pendingCount) {
+        if ((long)(now - pending[i].due) < 0) {
+            i++;
+            continue;
+        }
+        MockRequest request = pending[i];
+        pendingCount--;
+        memmove(&pending[i], &pending[i + 1], (pendingCount - i) * sizeof(MockRequest));
+        deliver(&request);
+    }
+}
+
+void MockDriver::reportStats() {
+    Serial.print("Mock pump: replies=");
+    Serial.print(replies);
+    Serial.print(", pending=");
+    Serial.println(pendingCount);
+}
+
+bool MockDriver::pollStatus(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'S', 0, callback, context);
+}
+
+bool MockDriver::authorize(uint8_t address, uint8_t nozzle, FuelMode mode, uint32_t quantity, uint16_t price) {
+    MockPost* post = findPost(address);
+    if (!post || post->code != '2' || post->nozzle != nozzle) return false;
+    post->mode = mode == FUEL_BY_VOLUME ? FUEL_BY_VOLUME : FUEL_BY_PRICE;
+    post->target = quantity;
+    post->price = price;
+    post->saleNozzle = nozzle;
+    post->liters = 0;
+    post->flowCredit = 0;
+    post->lastFlow = millis();
+    post->code = '6';
+    return true;
+}
+
+bool MockDriver::readLiveVolume(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'L', 0, callback, context);
+}
+
+bool MockDriver::readLiveAmount(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'R', 0, callback, context);
+}
+
+bool MockDriver::readFinalTotals(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'T', 0, callback, context);
+}
+
+bool MockDriver::readTotalizer(uint8_t address, uint8_t nozzle, Rs422Callback callback, void* context) {
+    if (nozzle < 1 || nozzle > NOZZLE_COUNT) return false;
+    return submit(address, 'C', nozzle, callback, context);
+}
+
+bool MockDriver::nozzleOff(uint8_t address) {
+    return submit(address, 'N', 0, nullptr, nullptr);
+}
+
+bool MockDriver::stop(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'N', 0, callback, context);
+}
+
+bool MockDriver::pause(uint8_t address, Rs422Callback callback, void* context) {
+    return submit(address, 'B', 0, callback, context);
+}
+
+bool MockDriver::resume(uint8_t address) {
+    return submit(address, 'G', 0, nullptr, nullptr);
+}
+
+void mockPumpLift(uint8_t address, uint8_t nozzle) {
+    MockPost* post = findPost(address);
+    if (!post || post->code != '1' || nozzle < 1 || nozzle > NOZZLE_COUNT) return;
+    post->nozzle = nozzle;
+    post->code = '2';
+}
+
+void mockPumpHangUp(uint8_t address) {
+    MockPost* post = findPost(address);
+    if (!post || !post->nozzle) return;
+    flow(post, millis());
+    post->nozzle = 0;
+    if (post->code == '2') {
+        post->code = '1';
+    } else if (post->code == '6' || post->code == '7' || post->code == '8') {
+        post->code = '9';
+    }
+}
+
+void mockPumpConsole() {
+    while (Serial.available() > 0) {
+        char key = Serial.read();
+        if (key == '>') {
+            consolePost = (consolePost + 1) % POST_COUNT;
+        } else if (key == '0') {
+            mockPumpHangUp(POST_ADDRESSES[consolePost]);
+        } else if (key >= '1' && key <= '9') {
+            mockPumpLift(POST_ADDRESSES[consolePost], key - '0');
+        }
+    }
+}
\ No newline at end of file
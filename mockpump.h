@@ -0,0 +1,116 @@
+// mockpump.h
+#ifndef MOCKPUMP_H
+#define MOCKPUMP_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "rs422.h"
+
+/* Имитатор ТРК: отвечает на запросы FSM без линии RS422, для проверки на стенде */
+
+// Ответ имитатора: вместо кадра протокола колбэк получает эту структуру
+struct MockReply {
+    char command;               // S, L, R, T, C; 0 — управляющая команда принята
+    char code;                  // Код статуса '1'..'9'
+    uint8_t nozzle;             // Цифра рукава ('0' — не снят); идёт сразу за кодом
+    uint32_t value;             // L, R, T: налив (0.01 л или сумма); C: счётчик (мл)
+    uint32_t amount;            // T: сумма
+};
+
+struct MockReplyView {
+    const MockReply* reply;
+
+    explicit MockReplyView(const uint8_t* frame) : reply((const MockReply*)frame) {}
+    static bool complete(int length) { return length >= (int)sizeof(MockReply); }
+    char command() const { return reply->command; }
+    uint8_t nozzleDigit() const { return reply->nozzle; }
+};
+
+struct MockStatusReply : MockReplyView {
+    explicit MockStatusReply(const uint8_t* frame) : MockReplyView(frame) {}
+    char code() const { return reply->code; }
+    bool nozzleUp() const { return reply->nozzle != '0'; }
+    const uint8_t* codeBytes() const { return (const uint8_t*)&reply->code; }
+};
+
+struct MockMonitorReply : MockReplyView {
+    explicit MockMonitorReply(const uint8_t* frame) : MockReplyView(frame) {}
+    bool value(uint32_t* value) const {
+        *value = reply->value;
+        return true;
+    }
+};
+
+struct MockTransactionEndReply : MockReplyView {
+    explicit MockTransactionEndReply(const uint8_t* frame) : MockReplyView(frame) {}
+    bool totals(uint32_t* liters, uint32_t* amount) const {
+        *liters = reply->value;
+        *amount = reply->amount;
+        return true;
+    }
+};
+
+struct MockTotalCounterReply : MockReplyView {
+    explicit MockTotalCounterReply(const uint8_t* frame) : MockReplyView(frame) {}
+    bool total(uint32_t* value) const {
+        *value = reply->value;
+        return true;
+    }
+};
+
+/**
+ * Pump driver that simulates a dispenser per post in software: status
+ * codes follow GasKitLink, an authorised nozzle flows at MOCK_FLOW_RATE
+ * until the preset is reached, and replies come back after
+ * MOCK_REPLY_DELAY. The nozzle is lifted and hung up by mockPumpLift and
+ * mockPumpHangUp (or from the debug port, see mockPumpConsole).
+ */
+struct MockDriver {
+    typedef MockReplyView ReplyView;
+    typedef MockStatusReply StatusReply;
+    typedef MockMonitorReply MonitorReply;
+    typedef MockTransactionEndReply TransactionEndReply;
+    typedef MockTotalCounterReply TotalCounterReply;
+
+    static void init();
+    static void service();
+    static void setPriority(uint8_t address, bool dispensing) {}
+    static void reportStats();
+
+    static bool pollStatus(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+    static bool probeStatus(uint8_t address, Rs422Callback callback, void* context) {
+        return pollStatus(address, callback, context);
+    }
+    static bool authorize(uint8_t address, uint8_t nozzle, FuelMode mode, uint32_t quantity, uint16_t price);
+    static bool readLiveVolume(uint8_t address, Rs422Callback callback, void* context);
+    static bool readLiveAmount(uint8_t address, Rs422Callback callback, void* context);
+    static bool readFinalTotals(uint8_t address, Rs422Callback callback, void* context);
+    static bool readTotalizer(uint8_t address, uint8_t nozzle, Rs422Callback callback, void* context);
+    static bool nozzleOff(uint8_t address);
+    static bool stop(uint8_t address, Rs422Callback callback, void* context);
+    static bool pause(uint8_t address, Rs422Callback callback, void* context);
+    static bool resume(uint8_t address);
+};
+
+/**
+ * Lifts a nozzle on a ready post (status 1 -> 2).
+ * @param address Post address (1-32).
+ * @param nozzle Nozzle number (1-9).
+ */
+void mockPumpLift(uint8_t address, uint8_t nozzle);
+
+/**
+ * Hangs the nozzle up: ends a running or paused transaction (status 9)
+ * or returns a lifted nozzle without an order to ready (status 1).
+ * @param address Post address (1-32).
+ */
+void mockPumpHangUp(uint8_t address);
+
+/**
+ * Reads debug port keys for the simulated customer of one post (the first
+ * post at start):
+ * '1'..'9' lift that nozzle, '0' hangs up, '>' moves to the next post.
+ */
+void mockPumpConsole();
+
+#endif
\ No newline at end of file
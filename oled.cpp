@@ -1,73 +1,630 @@
 #include "oled.h"
 #include "config.h"
+#include "twi.h"
+#include "glyphs.h"
+#include <avr/pgmspace.h>
 
-// Создаем объект для I2C дисплея SSD1306 128x64
+#if DISPLAY_ASYNC_FLUSH
+// Байты команд U8g2 (инициализация, очистка) идут через свой драйвер TWI; библиотека Wire не нужна
+static uint8_t byteBuffer[DISPLAY_BYTE_BUFFER];
+static uint8_t byteCount;
+
+extern "C" uint8_t u8x8_byte_twi(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr) {
+    switch (msg) {
+    case U8X8_MSG_BYTE_INIT:
+        initTWI(DISPLAY_I2C_CLOCK);
+        break;
+    case U8X8_MSG_BYTE_START_TRANSFER:
+        twiFlush();
+        byteCount = 0;
+        break;
+    case U8X8_MSG_BYTE_SEND:
+        if (byteCount + arg_int > DISPLAY_BYTE_BUFFER) return 0;
+        memcpy(byteBuffer + byteCount, arg_ptr, arg_int);
+        byteCount += arg_int;
+        break;
+    case U8X8_MSG_BYTE_END_TRANSFER:
+        twiWrite(SCREEN_ADDRESS, nullptr, 0, byteBuffer, byteCount);
+        twiFlush();
+        break;
+    case U8X8_MSG_BYTE_SET_DC:
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+// Буфер на весь кадр или на 1-2 строки тайлов
+#if DISPLAY_BUFFER_ROWS == 1
+#define OLED_SETUP u8g2_Setup_ssd1306_i2c_128x64_noname_1
+#elif DISPLAY_BUFFER_ROWS == 2
+#define OLED_SETUP u8g2_Setup_ssd1306_i2c_128x64_noname_2
+#else
+#define OLED_SETUP u8g2_Setup_ssd1306_i2c_128x64_noname_f
+#endif
+
+// SSD1306 128x64 на своём драйвере TWI
+class OledTwi : public U8G2 {
+public:
+    OledTwi() : U8G2() {
+        OLED_SETUP(&u8g2, U8G2_R0, u8x8_byte_twi, u8x8_gpio_and_delay_arduino);
+    }
+};
+static OledTwi u8g2;
+#else
+// Создаем объект для I2C дисплея SSD1306 128x64: буфер на весь кадр или на 1-2 строки тайлов
+#if DISPLAY_BUFFER_ROWS == 1
+U8G2_SSD1306_128X64_NONAME_1_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#elif DISPLAY_BUFFER_ROWS == 2
+U8G2_SSD1306_128X64_NONAME_2_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#else
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#endif
+#endif
+
+// Кадр делится на тайлы 8x8: строка тайлов — 128 байт буфера, тайл — 8 байт столбцов
+#define OLED_TILE_COLS (SCREEN_WIDTH / 8)
+#define OLED_TILE_ROWS (SCREEN_HEIGHT / 8)
+
+// Контрольные суммы тайлов последнего переданного кадра (вместо копии кадра в 1 КБ)
+static uint16_t tileSums[OLED_TILE_ROWS][OLED_TILE_COLS];
+static bool tilesValid = false;
+static unsigned long lastFullRefresh = 0;
+
+// Экран налива: строка статуса шрифтом, под ней литры и сумма крупными цифрами
+#define FIGURE_FIELDS 2
+#define FIGURE_CHARS ((SCREEN_WIDTH - FIGURE_LABEL_WIDTH) / FIGURE_DIGIT_WIDTH) // Знакомест в поле
+#define FIGURE_LABEL_WIDTH 16   // Подпись поля (L, P) слева
+#define FIGURE_FIRST_ROW 2      // Строка тайлов первого поля; поля идут подряд по FIGURE_TILE_ROWS
+static_assert(FIGURE_FIRST_ROW + FIGURE_FIELDS * FIGURE_TILE_ROWS <= SCREEN_HEIGHT / 8, "figure fields must fit on the screen");
+static const char figureLabels[FIGURE_FIELDS][2] = {"L", "P"};
+
+// Модель экрана: строки после переноса; по ней рисуется каждая страница буфера
+struct DisplayModel {
+    char lines[DISPLAY_MAX_LINES][DISPLAY_LINE_SIZE];
+    uint8_t lineCount;
+    bool figures;               // Экран налива: строка статуса и поля крупных цифр
+    DisplayText figureStatus;
+    char figureText[FIGURE_FIELDS][FIGURE_CHARS + 1]; // Выровнены вправо, слева пробелы
+};
+static DisplayModel model;
+
+// Поля крупных цифр в буфере кадра: по ним при изменении перерисовываются только сменившиеся знаки
+static char shownFigures[FIGURE_FIELDS][FIGURE_CHARS + 1];
+static bool figuresShown = false;
+static bool frameDelta = false; // Ждущий кадр отличается от показанного только знаками полей
+
+// Метрики шрифта считаются один раз при запуске
+static int8_t ascent;
+static int8_t lineHeight;
+
+static OledStats stats;
+static uint32_t savedAtReport = 0;
+static unsigned long lastReport = 0;
 
 void initOLED() {
+#if !DISPLAY_ASYNC_FLUSH
+    u8g2.setBusClock(DISPLAY_I2C_CLOCK);
+#endif
     u8g2.begin();
+    u8g2.setFont(u8g2_font_t0_15_tf);
+    ascent = u8g2.getAscent();                      // расстояние от базовой линии до верхней точки
+    lineHeight = ascent - u8g2.getDescent() + 4;    // высота строки с отступом
+    stats.bufferBytes = u8g2.getBufferTileHeight() * SCREEN_WIDTH;
 }
 
-bool displayMessage(const char* msg) {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_t0_15_tf);
-    
-    // Определяем высоту строки с учетом текущего шрифта
-    int ascent = u8g2.getAscent();      // расстояние от базовой линии до верхней точки
-    int descent = -u8g2.getDescent();     // делаем положительным
-    int lineHeight = ascent + descent + 4; // добавляем небольшой отступ, например 2 пикселя
-    
-    // Ширина дисплея (можно взять из SCREEN_WIDTH, если оно определено)
-    int displayWidth = 128;
-    
-    int y = ascent; // начинаем с высоты шрифта, чтобы первая строка не обрезалась
+/* Перенос текста по словам в модель: без strtok и временных строк на стеке */
+
+// Дописывает слово в текущую строку или, если оно не помещается по ширине, начинает новую
+static void appendWord(const char* word, uint8_t length, uint8_t* used) {
+    if (model.lineCount >= DISPLAY_MAX_LINES) return;
+    char* line = model.lines[model.lineCount];
+    uint8_t start = *used;
+    if (start > 0) {
+        if (start + 1 + length < DISPLAY_LINE_SIZE) {
+            line[start] = ' ';
+            memcpy(line + start + 1, word, length);
+            line[start + 1 + length] = '\0';
+            if (u8g2.getStrWidth(line) <= SCREEN_WIDTH) {
+                *used = start + 1 + length;
+                return;
+            }
+        }
+        // Не помещается: строка закрывается, слово идёт на следующую
+        line[start] = '\0';
+        if (++model.lineCount >= DISPLAY_MAX_LINES) return;
+        line = model.lines[model.lineCount];
+    }
+    if (length > DISPLAY_LINE_SIZE - 1) length = DISPLAY_LINE_SIZE - 1;
+    memcpy(line, word, length);
+    line[length] = '\0';
+    *used = length;
+}
+
+// Переносит текст в модель; lineEnds (может быть nullptr) получает смещения концов строк в msg
+static void layoutText(const char* msg, uint8_t* lineEnds) {
+    model.lineCount = 0;
     const char* ptr = msg;
-    
-    // Буфер для формирования строки
-    char line[128]; // увеличил размер буфера на случай длинных строк
-    
-    while (*ptr != '\0') {
-        int linePos = 0;
-        // Формируем строку до конца сообщения или до символа новой строки
-        while (*ptr != '\0' && *ptr != '\n' && linePos < (int)(sizeof(line) - 1)) {
-            line[linePos++] = *ptr++;
+    while (*ptr != '\0' && model.lineCount < DISPLAY_MAX_LINES) {
+        // Абзац до '\n': слова через любое число пробелов
+        uint8_t used = 0;
+        while (*ptr != '\0' && *ptr != '\n') {
+            if (*ptr == ' ') {
+                ptr++;
+                continue;
+            }
+            const char* word = ptr;
+            while (*ptr != '\0' && *ptr != ' ' && *ptr != '\n') ptr++;
+            appendWord(word, ptr - word, &used);
+            if (lineEnds && model.lineCount < DISPLAY_MAX_LINES) lineEnds[model.lineCount] = ptr - msg;
+        }
+        // Пустой абзац строки не занимает
+        if (used > 0 && model.lineCount < DISPLAY_MAX_LINES) model.lineCount++;
+        if (*ptr == '\n') ptr++;
+    }
+}
+
+/* Постоянные тексты: строки во флеш-памяти, переносы считаются при первом выводе и хранятся по номеру */
+
+static const char text0[] PROGMEM = "CENSTAR";
+static const char text1[] PROGMEM = "Please select mode";
+static const char text2[] PROGMEM = "Mode: Volume";
+static const char text3[] PROGMEM = "Mode: Price";
+static const char text4[] PROGMEM = "Mode: Full Tank";
+static const char text5[] PROGMEM = "Enter Volume";
+static const char text6[] PROGMEM = "Enter Amount";
+static const char text7[] PROGMEM = "Invalid volume!";
+static const char text8[] PROGMEM = "Invalid amount!";
+static const char text9[] PROGMEM = "Cleared";
+static const char text10[] PROGMEM = "Confirm? Press K";
+static const char text11[] PROGMEM = "Confirm! UP Nozzle";
+static const char text12[] PROGMEM = "Nozzle up! Hang up";
+static const char text13[] PROGMEM = "Nozzle back! Trans end";
+static const char text14[] PROGMEM = "Slow down! Wait";
+static const char text15[] PROGMEM = "Set price (0-99999)";
+static const char text16[] PROGMEM = "Editing Price";
+static const char text17[] PROGMEM = "Price cleared";
+static const char text18[] PROGMEM = "Price updated!";
+static const char text19[] PROGMEM = "Price too high! Max";
+static const char text20[] PROGMEM = "TOTAL:\nWaiting...";
+static const char text21[] PROGMEM = "TOTAL:\nError";
+static const char text22[] PROGMEM = "Pump Error";
+static const char text23[] PROGMEM = "Invalid response from pump";
+static const char text24[] PROGMEM = "Pump offline! Check";
+static const char text25[] PROGMEM = "Stop/pause failed!";
+static const char text26[] PROGMEM = "Nozzle up long! Check";
+static const char text27[] PROGMEM = "Trans error! Check pump";
+static const char text28[] PROGMEM = "Dispensing...";
+static const char text29[] PROGMEM = "Paused";
+static const char text30[] PROGMEM = "Filling end";
+static const char text31[] PROGMEM = "Trans stopped";
+static const char text32[] PROGMEM = "Restoring trans...";
+
+// Порядок совпадает с DisplayText
+static const char* const texts[] PROGMEM = {
+    text0, text1, text2, text3, text4, text5, text6, text7, text8, text9,
+    text10, text11, text12, text13, text14, text15, text16, text17, text18, text19,
+    text20, text21, text22, text23, text24, text25, text26, text27, text28, text29,
+    text30, text31, text32
+};
+static_assert(sizeof(texts) / sizeof(texts[0]) == TEXT_COUNT, "texts[] must list every DisplayText");
+
+// Переносы постоянного текста: конец каждой строки (смещение в тексте)
+struct TextLayout {
+    uint8_t lineCount;          // 0 — ещё не считались (в каждом тексте есть хотя бы одна строка)
+    uint8_t lineEnds[DISPLAY_MAX_LINES];
+};
+static TextLayout layouts[TEXT_COUNT];
+
+// Заполняет модель по сохранённым переносам: только копирование, без замеров ширины.
+// Слова в постоянных текстах разделены одним пробелом, поэтому строки совпадают с переносом
+static void layoutFromCache(const char* text, const TextLayout* layout) {
+    uint8_t pos = 0;
+    for (uint8_t i = 0; i < layout->lineCount; i++) {
+        char c;
+        while ((c = pgm_read_byte(text + pos)) == ' ' || c == '\n') pos++;
+        uint8_t end = layout->lineEnds[i];
+        uint8_t length = end - pos;
+        if (length > DISPLAY_LINE_SIZE - 1) length = DISPLAY_LINE_SIZE - 1;
+        memcpy_P(model.lines[i], text + pos, length);
+        model.lines[i][length] = '\0';
+        pos = end;
+    }
+    model.lineCount = layout->lineCount;
+}
+
+static uint8_t figureWidth(char c) {
+    return c == '.' ? FIGURE_POINT_WIDTH : FIGURE_DIGIT_WIDTH;
+}
+
+// Копирует знак поля в буфер: срезы строк тайлов row.., попавшие в страницу firstRow..firstRow+rows
+static void blitFigure(char c, uint8_t x, uint8_t row, uint8_t firstRow, uint8_t rows) {
+    uint8_t width = figureWidth(c);
+    uint8_t* buffer = u8g2.getBufferPtr();
+    for (uint8_t r = 0; r < FIGURE_TILE_ROWS; r++) {
+        int8_t pageOffset = row + r - firstRow;
+        if (pageOffset < 0 || pageOffset >= rows) continue;
+        uint8_t* dst = buffer + pageOffset * SCREEN_WIDTH + x;
+        if (c >= '0' && c <= '9') {
+            memcpy_P(dst, figureDigits[c - '0'][r], width);
+        } else if (c == '.') {
+            memcpy_P(dst, figurePoint[r], width);
+        } else {
+            memset(dst, 0, width);
+        }
+    }
+}
+
+// Поле выравнивается вправо: знаки раскладываются справа налево
+static void drawFigureField(uint8_t field, uint8_t firstRow, uint8_t rows) {
+    const char* text = model.figureText[field];
+    uint8_t row = FIGURE_FIRST_ROW + field * FIGURE_TILE_ROWS;
+    uint8_t x = SCREEN_WIDTH;
+    for (int8_t i = FIGURE_CHARS - 1; i >= 0; i--) {
+        x -= figureWidth(text[i]);
+        blitFigure(text[i], x, row, firstRow, rows);
+    }
+}
+
+static void drawModel(uint8_t firstRow, uint8_t rows) {
+    for (uint8_t i = 0; i < model.lineCount; i++) {
+        u8g2.drawStr(0, ascent + i * lineHeight, model.lines[i]);
+    }
+    if (!model.figures) return;
+    for (uint8_t field = 0; field < FIGURE_FIELDS; field++) {
+        u8g2.drawStr(0, (FIGURE_FIRST_ROW + field * FIGURE_TILE_ROWS) * 8 + ascent, figureLabels[field]);
+        drawFigureField(field, firstRow, rows);
+    }
+}
+
+// Флетчер-16 по восьми байтам тайла: изменение любого одного байта меняет сумму
+static uint16_t tileSum(const uint8_t* tile) {
+    uint8_t a = 0, b = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        a += tile[i];
+        b += a;
+    }
+    return (uint16_t)b << 8 | a;
+}
+
+// Отрезок изменившихся тайлов в строке: уходит на дисплей одной транзакцией
+struct TileSpan {
+    uint8_t row;
+    uint8_t first;
+    uint8_t count;
+};
+
+// Передача кадра: отрезки текущей страницы и следующая строка тайлов к отрисовке
+static TileSpan spans[OLED_TILE_ROWS];
+static uint8_t spanCount = 0;
+static uint8_t spanNext = 0;
+static uint8_t pageRow = 0;             // Первая строка тайлов страницы в буфере
+static uint8_t nextRow = 0;             // Следующая строка тайлов к отрисовке
+static bool frameActive = false;
+static bool framePending = false;
+static bool frameFull = false;
+static uint16_t frameSent = 0;
+static unsigned long frameStart = 0;
+static uint16_t twiErrorsSeen = 0;
+
+// Собирает отрезки изменившихся тайлов страницы: в каждой строке — от первого до последнего изменённого
+static uint16_t collectChangedTiles(uint8_t firstRow, uint8_t rows, bool full) {
+    uint8_t* buffer = u8g2.getBufferPtr();
+    uint16_t sent = 0;
+    spanCount = 0;
+    spanNext = 0;
+    for (uint8_t r = 0; r < rows && firstRow + r < OLED_TILE_ROWS; r++) {
+        uint8_t row = firstRow + r;
+        uint8_t* rowBuffer = buffer + r * SCREEN_WIDTH;
+        int8_t first = full ? 0 : -1;
+        int8_t last = full ? OLED_TILE_COLS - 1 : -1;
+        for (uint8_t col = 0; col < OLED_TILE_COLS; col++) {
+            uint16_t sum = tileSum(rowBuffer + col * 8);
+            if (sum != tileSums[row][col]) {
+                tileSums[row][col] = sum;
+                if (first < 0) first = col;
+                if (col > last) last = col;
+            }
         }
-        line[linePos] = '\0';
-        
-        // Если обнаружен символ новой строки, пропускаем его
-        if (*ptr == '\n') {
-            ptr++;
+        if (first >= 0) {
+            TileSpan* span = &spans[spanCount++];
+            span->row = row;
+            span->first = first;
+            span->count = last - first + 1;
+            sent += span->count * 8;
         }
-        
-        // Реализуем простую логику переноса: если строка длиннее дисплея, разделяем её по словам
-        char *token = strtok(line, " ");
-        char currentLine[128] = "";
-        while(token != NULL) {
-            // Проверяем, если добавление очередного слова не превышает дисплей
-            char tempLine[128];
-            if(strlen(currentLine) > 0)
-                snprintf(tempLine, sizeof(tempLine), "%s %s", currentLine, token);
-            else
-                snprintf(tempLine, sizeof(tempLine), "%s", token);
-            
-            if(u8g2.getStrWidth(tempLine) > displayWidth) {
-                // Если текущее накопленное слово уже выходит за пределы,
-                // выводим текущую строку и начинаем новую
-                u8g2.drawStr(0, y, currentLine);
-                y += lineHeight;
-                strcpy(currentLine, token); // начинаем новую строку с текущего слова
-            } else {
-                strcpy(currentLine, tempLine);
+    }
+    return sent;
+}
+
+// Отправляет следующий отрезок страницы; без DISPLAY_ASYNC_FLUSH — с ожиданием, через U8g2
+static bool sendNextSpan() {
+    if (spanNext >= spanCount) return false;
+    const TileSpan* span = &spans[spanNext];
+    uint8_t* tiles = u8g2.getBufferPtr() + (span->row - pageRow) * SCREEN_WIDTH + span->first * 8;
+#if DISPLAY_ASYNC_FLUSH
+    // Команды SSD1306 с битом Co (столбец, страница), затем поток данных — как u8x8_DrawTile
+    uint8_t x = span->first * 8;
+    uint8_t head[7] = {0x80, (uint8_t)(0x10 | (x >> 4)), 0x80, (uint8_t)(x & 0x0F),
+                       0x80, (uint8_t)(0xB0 | span->row), 0x40};
+    if (!twiWrite(SCREEN_ADDRESS, head, sizeof(head), tiles, span->count * 8)) return false;
+#else
+    u8x8_DrawTile(u8g2.getU8x8(), span->first, span->row, span->count, tiles);
+#endif
+    spanNext++;
+    return true;
+}
+
+static bool transferBusy() {
+#if DISPLAY_ASYNC_FLUSH
+    return twiBusy();
+#else
+    return false;
+#endif
+}
+
+// Кадр нарисован: счётчики и какие поля крупных цифр теперь в буфере
+static void finishRender() {
+    stats.frames++;
+    if (frameSent == 0) stats.unchanged++;
+    stats.bytesSent += frameSent;
+    stats.bytesSaved += SCREEN_WIDTH * SCREEN_HEIGHT / 8 - frameSent;
+    if (stats.lastRenderMicros > stats.maxRenderMicros) stats.maxRenderMicros = stats.lastRenderMicros;
+    figuresShown = model.figures;
+    if (model.figures) memcpy(shownFigures, model.figureText, sizeof(shownFigures));
+}
+
+// Рисует очередную страницу кадра из модели и собирает её изменившиеся тайлы
+static void renderPage() {
+    unsigned long start = micros();
+    uint8_t pageRows = u8g2.getBufferTileHeight();
+    pageRow = nextRow;
+    u8g2.setBufferCurrTileRow(pageRow);
+    u8g2.clearBuffer();
+    drawModel(pageRow, pageRows);
+    frameSent += collectChangedTiles(pageRow, pageRows, frameFull);
+    nextRow = pageRow + pageRows;
+    stats.lastRenderMicros += micros() - start;
+    if (nextRow >= OLED_TILE_ROWS) finishRender();
+}
+
+// Точка в другом знакоместе сдвигает все знаки левее неё: поле перерисовывается целиком
+static bool samePointPosition(const char* a, const char* b) {
+    for (uint8_t i = 0; i < FIGURE_CHARS; i++) {
+        if ((a[i] == '.') != (b[i] == '.')) return false;
+    }
+    return true;
+}
+
+// Кадр целиком в буфере, сменились только знаки полей: копируются глифы сменившихся знаков,
+// на дисплей уходят только их тайлы; очистки буфера, шрифта и сумм остальных тайлов нет
+static void renderFigureDelta() {
+    unsigned long start = micros();
+    spanCount = 0;
+    spanNext = 0;
+    pageRow = 0;
+    for (uint8_t field = 0; field < FIGURE_FIELDS; field++) {
+        const char* text = model.figureText[field];
+        char* shown = shownFigures[field];
+        uint8_t row = FIGURE_FIRST_ROW + field * FIGURE_TILE_ROWS;
+        bool whole = !samePointPosition(text, shown);
+        int8_t first = -1;
+        int8_t last = -1;
+        uint8_t x = SCREEN_WIDTH;
+        for (int8_t i = FIGURE_CHARS - 1; i >= 0; i--) {
+            uint8_t width = figureWidth(text[i]);
+            x -= width;
+            if (!whole && text[i] == shown[i]) continue;
+            blitFigure(text[i], x, row, 0, OLED_TILE_ROWS);
+            first = x / 8;
+            if (last < 0) last = (x + width - 1) / 8;
+        }
+        if (whole) {
+            // Хвост прежнего поля левее первого знака
+            for (uint8_t r = 0; r < FIGURE_TILE_ROWS; r++) {
+                memset(u8g2.getBufferPtr() + (row + r) * SCREEN_WIDTH + FIGURE_LABEL_WIDTH, 0, x - FIGURE_LABEL_WIDTH);
             }
-            token = strtok(NULL, " ");
+            first = FIGURE_LABEL_WIDTH / 8;
         }
-        // Выводим оставшуюся часть строки
-        if(strlen(currentLine) > 0) {
-            u8g2.drawStr(0, y, currentLine);
-            y += lineHeight;
+        memcpy(shown, text, FIGURE_CHARS + 1);
+        if (first < 0) continue;
+        for (uint8_t r = 0; r < FIGURE_TILE_ROWS; r++) {
+            uint8_t* rowBuffer = u8g2.getBufferPtr() + (row + r) * SCREEN_WIDTH;
+            for (uint8_t col = first; col <= last; col++) {
+                tileSums[row + r][col] = tileSum(rowBuffer + col * 8);
+            }
+            TileSpan* span = &spans[spanCount++];
+            span->row = row + r;
+            span->first = first;
+            span->count = last - first + 1;
+            frameSent += span->count * 8;
+        }
+    }
+    nextRow = OLED_TILE_ROWS;
+    stats.figureDeltas++;
+    stats.lastRenderMicros = micros() - start;
+    finishRender();
+}
+
+// Начинает кадр: полный при первом выводе, после ошибки передачи и раз в DISPLAY_REFRESH_INTERVAL
+static void startFrame() {
+    unsigned long now = millis();
+    framePending = false;
+    frameFull = !tilesValid || now - lastFullRefresh >= DISPLAY_REFRESH_INTERVAL;
+    if (frameFull) {
+        tilesValid = true;
+        lastFullRefresh = now;
+    }
+    frameActive = true;
+    frameSent = 0;
+    frameStart = micros();
+    stats.lastRenderMicros = 0;
+    nextRow = 0;
+    // Частичная перерисовка возможна, только пока весь кадр лежит в буфере
+    if (frameDelta && !frameFull && u8g2.getBufferTileHeight() >= OLED_TILE_ROWS) {
+        renderFigureDelta();
+    } else {
+        renderPage();
+    }
+    frameDelta = false;
+}
+
+void oledService() {
+#if DISPLAY_ASYNC_FLUSH
+    // Транзакция не подтверждена дисплеем: суммы тайлов уже не отражают экран
+    uint16_t errors = twiErrorCount();
+    if (errors != twiErrorsSeen) {
+        twiErrorsSeen = errors;
+        tilesValid = false;
+        framePending = true;
+    }
+#endif
+    while (!transferBusy()) {
+        if (sendNextSpan()) continue;
+        if (frameActive) {
+            if (nextRow < OLED_TILE_ROWS) {
+                // Страница передана: буфер свободен для следующей
+                renderPage();
+            } else {
+                frameActive = false;
+                stats.lastFlushMicros = micros() - frameStart;
+                if (stats.lastFlushMicros > stats.maxFlushMicros) stats.maxFlushMicros = stats.lastFlushMicros;
+            }
+        } else if (framePending) {
+            startFrame();
+        } else {
+            break;
         }
     }
-    
-    u8g2.sendBuffer();
+}
+
+bool oledBusy() {
+    return frameActive || transferBusy();
+}
+
+// Модель изменилась: кадр ждёт начала; ещё не начатый заменяется новым, очередь кадров не растёт
+static void requestFrame() {
+    if (framePending) stats.coalesced++;
+    framePending = true;
+    oledService();
+}
+
+bool displayMessage(const char* msg) {
+    model.figures = false;
+    frameDelta = false;
+    layoutText(msg, nullptr);
+    stats.wrapped++;
+    requestFrame();
+    return true;
+}
+
+// Переносы постоянного текста в модель: при первом выводе — перенос, дальше — из кэша
+static void layoutDisplayText(DisplayText text) {
+    const char* source = (const char*)pgm_read_ptr(&texts[text]);
+    TextLayout* layout = &layouts[text];
+    if (layout->lineCount == 0) {
+        // Первый вывод: перенос копии текста, концы строк запоминаются
+        char copy[DISPLAY_TEXT_SIZE];
+        strncpy_P(copy, source, sizeof(copy) - 1);
+        copy[sizeof(copy) - 1] = '\0';
+        layoutText(copy, layout->lineEnds);
+        layout->lineCount = model.lineCount;
+        stats.wrapped++;
+    } else {
+        layoutFromCache(source, layout);
+        stats.cachedLayouts++;
+    }
+}
+
+bool displayText(DisplayText text) {
+    if (text >= TEXT_COUNT) return false;
+    model.figures = false;
+    frameDelta = false;
+    layoutDisplayText(text);
+    requestFrame();
+    return true;
+}
+
+// Выравнивает значение вправо в FIGURE_CHARS знакомест; не поместившиеся старшие знаки отбрасываются
+static void setFigureField(char* field, const char* value) {
+    uint8_t length = strlen(value);
+    if (length > FIGURE_CHARS) {
+        value += length - FIGURE_CHARS;
+        length = FIGURE_CHARS;
+    }
+    uint8_t pad = FIGURE_CHARS - length;
+    memset(field, ' ', pad);
+    for (uint8_t i = 0; i < length; i++) {
+        char c = value[i];
+        field[pad + i] = (c >= '0' && c <= '9') || c == '.' ? c : ' ';
+    }
+    field[FIGURE_CHARS] = '\0';
+}
+
+bool displayFigures(DisplayText status, const char* liters, const char* money) {
+    if (status >= TEXT_COUNT) return false;
+    // Тот же статус и в буфере уже экран налива: кадр меняет только знаки полей
+    bool sameScreen = model.figures && model.figureStatus == status;
+    bool delta = sameScreen && (framePending ? frameDelta : figuresShown);
+    if (!sameScreen) {
+        layoutDisplayText(status);
+        model.lineCount = 1;
+        model.figureStatus = status;
+        model.figures = true;
+    }
+    setFigureField(model.figureText[0], liters);
+    setFigureField(model.figureText[1], money);
+    frameDelta = delta;
+    requestFrame();
     return true;
 }
+
+char* appendDisplayText(char* dst, DisplayText text) {
+    if (text >= TEXT_COUNT) {
+        *dst = '\0';
+        return dst;
+    }
+    strncpy_P(dst, (const char*)pgm_read_ptr(&texts[text]), DISPLAY_TEXT_SIZE - 1);
+    dst[DISPLAY_TEXT_SIZE - 1] = '\0';
+    return dst + strlen(dst);
+}
+
+const OledStats* oledGetStats() {
+    return &stats;
+}
+
+void oledReportStats() {
+    unsigned long now = millis();
+    unsigned long window = now - lastReport;
+    uint32_t savedPerSecond = window ? (stats.bytesSaved - savedAtReport) * 1000UL / window : 0;
+    lastReport = now;
+    savedAtReport = stats.bytesSaved;
+    Serial.print("Display: frames=");
+    Serial.print(stats.frames);
+    Serial.print(", unchanged=");
+    Serial.print(stats.unchanged);
+    Serial.print(", sent=");
+    Serial.print(stats.bytesSent);
+    Serial.print(" B, I2C saved=");
+    Serial.print(savedPerSecond);
+    Serial.println(" B/s");
+    Serial.print("Display buffer: ");
+    Serial.print(stats.bufferBytes);
+    Serial.print(" B, render last=");
+    Serial.print(stats.lastRenderMicros);
+    Serial.print(" us, max=");
+    Serial.print(stats.maxRenderMicros);
+    Serial.print(" us, flush last=");
+    Serial.print(stats.lastFlushMicros);
+    Serial.print(" us, max=");
+    Serial.print(stats.maxFlushMicros);
+    Serial.print(" us, coalesced=");
+    Serial.println(stats.coalesced);
+    Serial.print("Display layout: wrapped=");
+    Serial.print(stats.wrapped);
+    Serial.print(", cached=");
+    Serial.print(stats.cachedLayouts);
+    Serial.print(", figure deltas=");
+    Serial.println(stats.figureDeltas);
+}
\ No newline at end of file
@@ -4,7 +4,130 @@
 #include <Arduino.h>
 #include <U8g2lib.h>
 
+// Статистика вывода на дисплей
+struct OledStats {
+    uint32_t frames;            // Вызовов вывода кадра
+    uint32_t unchanged;         // Из них без передачи по I2C (кадр не изменился)
+    uint32_t bytesSent;         // Байт кадра, переданных дисплею
+    uint32_t bytesSaved;        // Байт, не переданных благодаря сравнению тайлов
+    uint16_t bufferBytes;       // ОЗУ буфера кадра (DISPLAY_BUFFER_ROWS строк тайлов)
+    uint32_t lastRenderMicros;  // Отрисовка кадра из модели (мкс)
+    uint32_t maxRenderMicros;
+    uint32_t lastFlushMicros;   // От начала отрисовки до конца передачи кадра по I2C (мкс)
+    uint32_t maxFlushMicros;
+    uint32_t coalesced;         // Кадры, заменённые новыми до начала передачи
+    uint32_t wrapped;           // Тексты, прошедшие перенос по словам
+    uint32_t cachedLayouts;     // Постоянные тексты, выведенные по сохранённым переносам
+    uint32_t figureDeltas;      // Кадры налива, где перерисованы только сменившиеся цифры
+};
+
+// Постоянные тексты экрана (строки во флеш-памяти, oled.cpp)
+typedef enum : uint8_t {
+    TEXT_WELCOME,
+    TEXT_SELECT_MODE,
+    TEXT_MODE_VOLUME,
+    TEXT_MODE_PRICE,
+    TEXT_MODE_FULL_TANK,
+    TEXT_ENTER_VOLUME,
+    TEXT_ENTER_AMOUNT,
+    TEXT_INVALID_VOLUME,
+    TEXT_INVALID_AMOUNT,
+    TEXT_CLEARED,
+    TEXT_CONFIRM_PRESS_K,
+    TEXT_CONFIRM_UP_NOZZLE,
+    TEXT_NOZZLE_UP,
+    TEXT_NOZZLE_BACK,
+    TEXT_SLOW_DOWN,
+    TEXT_SET_PRICE,
+    TEXT_EDITING_PRICE,
+    TEXT_PRICE_CLEARED,
+    TEXT_PRICE_UPDATED,
+    TEXT_PRICE_TOO_HIGH,
+    TEXT_TOTAL_WAITING,
+    TEXT_TOTAL_ERROR,
+    TEXT_PUMP_ERROR,
+    TEXT_INVALID_RESPONSE,
+    TEXT_PUMP_OFFLINE,
+    TEXT_STOP_PAUSE_FAILED,
+    TEXT_NOZZLE_UP_LONG,
+    TEXT_TRANS_ERROR,
+    TEXT_DISPENSING,
+    TEXT_PAUSED,
+    TEXT_FILLING_END,
+    TEXT_TRANS_STOPPED,
+    TEXT_RESTORING,
+    TEXT_COUNT
+} DisplayText;
+
 void initOLED();
+
+/**
+ * Shows a composed message (word-wrapped, '\n' starts a new line); fixed
+ * texts go through displayText instead. The text is
+ * wrapped once into a line model; the frame is drawn from it page by page
+ * when the buffer holds only DISPLAY_BUFFER_ROWS tile rows, and only the
+ * 8x8 tiles that differ from the previous frame are sent. Tiles are
+ * compared by checksum; nothing goes over I2C when the frame is unchanged,
+ * and the whole frame is resent every DISPLAY_REFRESH_INTERVAL.
+ * With DISPLAY_ASYNC_FLUSH the transfer is advanced by oledService() polling
+ * the TWI module and the call returns at once; while a frame is in flight, newer messages replace
+ * each other and only the last one is drawn next.
+ * @param msg Text to display.
+ * @return true.
+ */
 bool displayMessage(const char* msg);
 
+/**
+ * Shows one of the fixed texts. Its line breaks are computed by the wrap
+ * engine on first use and kept per text; later calls only copy the lines
+ * from flash into the line model. Drawn and sent like displayMessage.
+ * @param text Text identifier.
+ * @return false if the identifier is out of range.
+ */
+bool displayText(DisplayText text);
+
+/**
+ * Transaction screen: a status line in the text font and two fields,
+ * liters and money, in large digits copied from pre-rasterised bitmaps
+ * (glyphs.h). Fields are right-aligned; characters other than digits and
+ * '.' show as blanks, digits that do not fit are dropped from the left.
+ * With a full frame buffer and the same status as the frame on the
+ * display, only the glyphs of changed characters are copied and only
+ * their tiles are sent.
+ * @param status Status line text.
+ * @param liters Liters field, e.g. "12.34".
+ * @param money Money field, e.g. "617".
+ * @return false if the status identifier is out of range.
+ */
+bool displayFigures(DisplayText status, const char* liters, const char* money);
+
+/**
+ * Copies a fixed text from flash, e.g. as the first line of a composed message.
+ * @param dst Output buffer, at least DISPLAY_TEXT_SIZE bytes.
+ * @param text Text identifier.
+ * @return Pointer to the terminating NUL.
+ */
+char* appendDisplayText(char* dst, DisplayText text);
+
+/**
+ * Advances the display transfer: sends the next tile span, draws the next
+ * page once the buffer has been sent, starts a waiting frame. Never blocks;
+ * call from the main loop.
+ */
+void oledService();
+
+/**
+ * Returns true while a frame is being drawn or sent.
+ */
+bool oledBusy();
+
+const OledStats* oledGetStats();
+
+/**
+ * Prints display transfer counters, the I2C bytes per second saved since
+ * the previous report, buffer RAM, render and flush time and the share of
+ * texts drawn from cached layouts to the debug port.
+ */
+void oledReportStats();
+
 #endif
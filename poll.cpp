@@ -0,0 +1,80 @@
+// poll.cpp
+#include "poll.h"
+#include "config.h"
+
+struct PollProfileConfig {
+    uint16_t minInterval;       // Период опроса сразу после события (мс)
+    uint16_t maxInterval;       // Предел затухания (мс)
+    uint8_t weight[3];          // Доли S, L, R во взвешенном круговом выборе
+};
+
+static const PollProfileConfig profiles[POLL_PROFILE_COUNT] = {
+    {POLL_IDLE_INTERVAL_MIN, POLL_IDLE_INTERVAL_MAX, {1, 0, 0}},
+    {POLL_DISPENSE_INTERVAL, POLL_DISPENSE_INTERVAL, {POLL_DISPENSE_WEIGHT_S, POLL_DISPENSE_WEIGHT_L, POLL_DISPENSE_WEIGHT_R}},
+    {POLL_PAUSED_INTERVAL, POLL_PAUSED_INTERVAL, {1, 0, 0}}
+};
+
+static const char pollCommands[3] = {'S', 'L', 'R'};
+
+void initPoll(PollScheduler* poll, PollProfile profile) {
+    poll->profile = profile;
+    poll->quietPolls = 0;
+    poll->forceStatus = true;
+    for (uint8_t i = 0; i < 3; i++) poll->credit[i] = 0;
+    poll->lastStatus[0] = poll->lastStatus[1] = 0;
+    poll->interval = profiles[profile].minInterval;
+    poll->lastPoll = 0;
+}
+
+void pollSelect(PollScheduler* poll, PollProfile profile) {
+    if (poll->profile == profile) return;
+    uint16_t lastPoll = poll->lastPoll;
+    initPoll(poll, profile);
+    poll->lastPoll = lastPoll;
+}
+
+bool pollDue(const PollScheduler* poll, unsigned long now) {
+    return (uint16_t)((uint16_t)now - poll->lastPoll) >= poll->interval;
+}
+
+char pollNext(PollScheduler* poll, unsigned long now) {
+    poll->lastPoll = now;
+    if (poll->forceStatus) {
+        poll->forceStatus = false;
+        return 'S';
+    }
+    // Плавный взвешенный круговой выбор: команды перемежаются, а не идут пачками
+    const PollProfileConfig* config = &profiles[poll->profile];
+    int8_t total = 0;
+    uint8_t best = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        poll->credit[i] += config->weight[i];
+        total += config->weight[i];
+        if (poll->credit[i] > poll->credit[best]) best = i;
+    }
+    poll->credit[best] -= total;
+    return pollCommands[best];
+}
+
+void pollOnStatus(PollScheduler* poll, const uint8_t* code) {
+    const PollProfileConfig* config = &profiles[poll->profile];
+    if (code[0] != poll->lastStatus[0] || code[1] != poll->lastStatus[1]) {
+        poll->lastStatus[0] = code[0];
+        poll->lastStatus[1] = code[1];
+        poll->quietPolls = 0;
+        poll->interval = config->minInterval;
+        return;
+    }
+    if (config->maxInterval <= config->minInterval) return;
+    if (++poll->quietPolls >= POLL_QUIET_POLLS) {
+        poll->quietPolls = 0;
+        uint16_t next = poll->interval * 2;
+        poll->interval = next > config->maxInterval ? config->maxInterval : next;
+    }
+}
+
+void pollEscalate(PollScheduler* poll) {
+    poll->interval = profiles[poll->profile].minInterval;
+    poll->quietPolls = 0;
+    poll->forceStatus = true;
+}
\ No newline at end of file
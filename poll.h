@@ -0,0 +1,72 @@
+// poll.h
+#ifndef POLL_H
+#define POLL_H
+
+#include <Arduino.h>
+
+typedef enum {
+    POLL_PROFILE_IDLE,          // Ожидание: только S, период растёт до «пульса»
+    POLL_PROFILE_DISPENSING,    // Налив: L/R чаще, S реже
+    POLL_PROFILE_PAUSED,        // Пауза: только S с умеренным периодом
+    POLL_PROFILE_COUNT
+} PollProfile;
+
+/**
+ * Per-post polling cadence: which of S/L/R to ask next and when.
+ * Commands are interleaved by smooth weighted round-robin; in IDLE the
+ * period doubles after a run of unchanged replies and drops back to the
+ * minimum on a key press or a status change.
+ */
+struct PollScheduler {
+    uint8_t profile : 2;
+    bool forceStatus : 1;       // Следующим запросом должен быть S
+    uint8_t quietPolls;         // Ответов подряд без изменения статуса
+    int8_t credit[3];           // Счётчики взвешенного кругового выбора S, L, R
+    char lastStatus[2];
+    uint16_t interval;          // Текущий период опроса (мс)
+    uint16_t lastPoll;          // Младшие 16 бит millis()
+};
+
+/**
+ * Resets the scheduler to the fastest cadence of a profile.
+ * @param poll Scheduler.
+ * @param profile Initial profile.
+ */
+void initPoll(PollScheduler* poll, PollProfile profile);
+
+/**
+ * Selects the polling profile. Switching to another profile resets the
+ * cadence to its fastest rate and asks for a status poll first.
+ * @param poll Scheduler.
+ * @param profile Profile for the current FSM state.
+ */
+void pollSelect(PollScheduler* poll, PollProfile profile);
+
+/**
+ * Returns true when the next poll may be sent.
+ * @param poll Scheduler.
+ * @param now Current millis().
+ */
+bool pollDue(const PollScheduler* poll, unsigned long now);
+
+/**
+ * Picks the next command ('S', 'L' or 'R') and marks the poll as sent.
+ * @param poll Scheduler.
+ * @param now Current millis().
+ * @return Command byte.
+ */
+char pollNext(PollScheduler* poll, unsigned long now);
+
+/**
+ * Feeds a status reply into the back-off logic.
+ * @param poll Scheduler.
+ * @param code Two status characters of the 'S' reply.
+ */
+void pollOnStatus(PollScheduler* poll, const uint8_t* code);
+
+/**
+ * Drops to the fastest cadence and polls status next (key press, operator action).
+ */
+void pollEscalate(PollScheduler* poll);
+
+#endif
\ No newline at end of file
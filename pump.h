@@ -0,0 +1,39 @@
+// pump.h
+#ifndef PUMP_H
+#define PUMP_H
+
+#include "config.h"
+
+/*
+ * Pump driver: the protocol the FSM talks to a dispenser head with,
+ * chosen at build time by PUMP_DRIVER. A driver is a struct of static
+ * members, so calls are direct and can be inlined; there is no vtable.
+ *
+ * Operations (address is the post address, 1-32):
+ *   init(), service(), setPriority(address, dispensing), reportStats()
+ *   pollStatus / probeStatus     status poll (a probe is never retried)
+ *   authorize                    preset by volume, money or full tank
+ *   readLiveVolume / readLiveAmount   running totals while dispensing
+ *   readFinalTotals              totals of the finished transaction
+ *   readTotalizer                nozzle totalizer (ml)
+ *   nozzleOff, stop, pause, resume
+ *
+ * Replies arrive in an Rs422Callback and are read through the driver's
+ * view types: ReplyView, StatusReply, MonitorReply, TransactionEndReply
+ * and TotalCounterReply (see message.h for the members). A reply names the
+ * operation it answers with the poll scheduler's letter: S status,
+ * L live volume, R live amount, T final totals, C totalizer. Status codes
+ * are GasKitLink's digits (1 ready, 2 nozzle up, 3/4 authorised,
+ * 6 dispensing, 7 paused, 8 stopped, 9 finished); a driver for another
+ * head maps its states onto them.
+ */
+
+#if PUMP_DRIVER == PUMP_DRIVER_MOCK
+#include "mockpump.h"
+typedef MockDriver PumpDriver;
+#else
+#include "censtar.h"
+typedef CenstarDriver PumpDriver;
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+// retry.cpp
+#include "retry.h"
+#include "config.h"
+
+static const RetryPolicy policies[] = {
+    {'S', RETRY_BUDGET_STATUS, true},
+    {'L', RETRY_BUDGET_MONITOR, true},
+    {'R', RETRY_BUDGET_MONITOR, true},
+    {'T', RETRY_BUDGET_TRANSACTION_END, true},
+    {'C', RETRY_BUDGET_TOTAL, true},
+    {'N', RETRY_BUDGET_CONTROL, true},
+    {'B', RETRY_BUDGET_CONTROL, true},
+    {'G', RETRY_BUDGET_CONTROL, true},
+    // V и M разрешают налив: повтор после потерянного ответа может запустить второй отпуск
+    {'V', 0, false},
+    {'M', 0, false}
+};
+
+const RetryPolicy* retryPolicy(char command) {
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (policies[i].command == command) return &policies[i];
+    }
+    return nullptr;
+}
+
+bool retryAllowed(char command, uint8_t attempt) {
+    const RetryPolicy* policy = retryPolicy(command);
+    return policy && policy->idempotent && attempt < policy->budget;
+}
+
+uint16_t retryBackoff(uint8_t attempt) {
+    uint16_t delayMs = RETRY_BACKOFF_MAX;
+    if (attempt > 0 && attempt <= 8) {
+        uint32_t exp = (uint32_t)RETRY_BACKOFF_BASE << (attempt - 1);
+        if (exp < RETRY_BACKOFF_MAX) delayMs = exp;
+    }
+    return delayMs + random(delayMs / 2 + 1);
+}
\ No newline at end of file
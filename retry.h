@@ -0,0 +1,40 @@
+// retry.h
+#ifndef RETRY_H
+#define RETRY_H
+
+#include <Arduino.h>
+
+/**
+ * Resend policy of one bus command. Failed exchanges (no reply, bad CRC)
+ * are repeated by the bus layer itself, so the FSM sees a failure only
+ * after the command's budget is spent.
+ */
+struct RetryPolicy {
+    char command;
+    uint8_t budget;             // Повторов после первой попытки
+    bool idempotent;            // Повтор безопасен: ТРК не выполнит действие дважды
+};
+
+/**
+ * Returns the policy of a command (nullptr — never resent).
+ * @param command Request command byte.
+ */
+const RetryPolicy* retryPolicy(char command);
+
+/**
+ * Returns true if a failed request may be sent again.
+ * @param command Request command byte.
+ * @param attempt Retries already made for this request.
+ */
+bool retryAllowed(char command, uint8_t attempt);
+
+/**
+ * Returns the pause before a retry: RETRY_BACKOFF_BASE doubled per
+ * previous retry, capped at RETRY_BACKOFF_MAX, plus up to 50% random
+ * jitter so that several silent posts do not retry in lockstep.
+ * @param attempt Retry number (1 — first retry).
+ * @return Pause in milliseconds.
+ */
+uint16_t retryBackoff(uint8_t attempt);
+
+#endif
\ No newline at end of file
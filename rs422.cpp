@@ -3,11 +3,68 @@
 #include "frame.h"
 #include "config.h"
 #include "crc.h"
-#include "oled.h" // Добавлено для displayMessage
-
-static const uint8_t slaveAddress[2] = {0x00, POST_ADDRESS};
-static bool isSending = false;
-static bool isReceiving = false;
+#include "uart.h"
+#include "rtt.h"
+#include "retry.h"
+#include "message.h"
+#include "utils.h"
+
+// Запрос в очереди шины
+struct Rs422Request {
+    uint8_t address;            // Адрес поста (1-32)
+    char command;
+    char replyCommand;          // Ожидаемая команда ответа (0 — любой кадр или тишина)
+    uint8_t payloadLength;
+    uint8_t payload[MAX_FRAME_PAYLOAD];
+    uint16_t timeout;           // Ожидание ответа от конца передачи (мс, 0 — по оценке RTT)
+    uint8_t attempt;            // Сделано повторов
+    bool retry;                 // Повтор по политике команды разрешён
+    bool urgent;                // Срочная команда оператора (стоп, пауза): идёт вне очереди
+    uint16_t notBefore;         // Повтор не раньше этого момента (младшие 16 бит millis())
+    unsigned long submitTime;   // Момент постановки в очередь (micros())
+    Rs422Callback callback;
+    void* context;
+};
+
+// Очередь в порядке постановки; выбор следующего запроса — в startNext
+static Rs422Request queue[RS422_QUEUE_SIZE];
+static uint8_t queueCount = 0;
+
+// Посты с активным наливом (бит на адрес) и счётчик их запросов подряд
+static uint32_t priorityPosts = 0;
+static uint8_t priorityStreak = 0;
+
+// Запрос на линии: передан и ждёт ответа
+static Rs422Request current;
+static bool inFlight = false;
+static uint16_t currentTimeout = 0;
+static Rs422Stats stats;
+static unsigned long rateWindowStart = 0;
+static uint16_t rateWindowFrames = 0;
+static bool servicing = false;
+
+// Состояние приёма ответа: кадр собирается декодером между вызовами rs422Service
+static FrameDecoder rxDecoder;
+static uint16_t rxLastStamp = 0;
+static uint16_t rxFirstStamp = 0;       // Метка первого байта принимаемого кадра
+static bool lineDirty = false;          // В линии были байты вне целого ответа: ждём паузы
+static unsigned long completeMicros = 0;
+
+// Посты, ответившие на последний запрос (бит на адрес): ими ограничен подбор скорости
+static uint32_t postsSeen = 0;
+
+// Подбор скорости линии: пока он идёт, в линию уходят только пробные S и срочные команды,
+// обычные запросы не принимаются. Пробный S ждёт в своём месте вне очереди
+#define BAUD_RATE_COUNT (sizeof(RS422_BAUD_RATES) / sizeof(RS422_BAUD_RATES[0]))
+static int8_t detectRate = -1;          // Индекс проверяемой скорости (-1 — подбор не идёт)
+static uint8_t detectPost = 0;          // Индекс в POST_ADDRESSES поста, которому отправлен пробный S
+static Rs422Request probe;
+static bool probePending = false;       // Пробный S ждёт линии
+static uint8_t rateIndex = 0;           // Индекс текущей скорости в RS422_BAUD_RATES
+static uint8_t crcStreak = 0;           // Ошибок CRC подряд на текущей скорости
+
+static void onBaudProbe(void* context, Rs422RxStatus status, const uint8_t* reply, int length);
+static void startBaudDetect(uint8_t fromRate);
 
 void log(int level, const char* msg) {
     if (level >= LOG_LEVEL) {
@@ -15,212 +72,603 @@ void log(int level, const char* msg) {
     }
 }
 
-static void flushInput(unsigned long timeoutUs = 2000) {
-    unsigned long t0 = micros();
-    while (micros() - t0 < timeoutUs) {
-        if (Serial1.available()) {
-            uint8_t byte = Serial1.read();
-            if (byte == 0x02 || byte == 0x04) t0 = micros();
+// Линия чиста, если после целого ответа не пришло ни байта. После оборванного
+// ответа, CRC-ошибки или мусора следующий кадр ждёт межбайтовой паузы: опоздавший
+// пост ещё может передавать, и его хвост смешался бы с новым ответом
+static bool lineClean() {
+    uint8_t data;
+    uint16_t stamp;
+    while (uartRead(&data, &stamp)) {
+        rxLastStamp = stamp;
+        lineDirty = true;
+    }
+    if (!lineDirty) return true;
+    if ((uint16_t)(uartTicks() - rxLastStamp) < uartGapTicks()) return false;
+    lineDirty = false;
+    return true;
+}
+
+// Запись кадра в линию и начало ожидания ответа на него.
+// Кадры постоянных команд берутся готовыми из флеш-памяти, остальные собираются
+static bool sendFrame(const Rs422Request* request) {
+    frameDecoderReset(&rxDecoder, request->address);
+    uint8_t length;
+    const uint8_t* frame = fixedFrame(request->address, request->command, request->payload, request->payloadLength, &length);
+    bool queued;
+    if (frame) {
+        queued = uartWriteP(frame, length);
+    } else {
+        uint8_t address[2] = {0x00, request->address};
+        uint8_t frameBuffer[MAX_FRAME_PAYLOAD + 5];
+        int frameLength = 0;
+        assembleFrame(address, request->command, request->payload, request->payloadLength, frameBuffer, &frameLength);
+        queued = uartWrite(frameBuffer, frameLength);
+    }
+    if (!queued) {
+        log(LOG_LEVEL_ERROR, "TX queue full");
+        return false;
+    }
+    return true;
+}
+
+// Управляющей команде подходит любой кадр, кроме ответа на опрос: такой кадр —
+// опоздавший ответ на опрос, прерванный срочной командой, а не её подтверждение
+static bool replyMatches(char replyCommand) {
+    if (replyCommand == 0) return messageReplyLength(rxDecoder.buffer, rxDecoder.count) == 0;
+    return rxDecoder.buffer[3] == (uint8_t)replyCommand;
+}
+
+// Неблокирующая проверка ответа на текущий запрос
+static Rs422RxStatus pollResponse(char replyCommand, uint16_t timeout) {
+    // Забираем накопленные прерыванием байты, не дожидаясь новых
+    uint8_t data;
+    uint16_t stamp;
+    while (uartRead(&data, &stamp)) {
+        rxLastStamp = stamp;
+        if (!frameDecoderBusy(&rxDecoder)) rxFirstStamp = stamp;
+        FrameFeedResult result = frameDecoderFeed(&rxDecoder, data);
+        if (result == FRAME_FEED_COMPLETE) {
+            if (!replyMatches(replyCommand)) {
+                log(LOG_LEVEL_DEBUG, "Stale response skipped");
+                continue;
+            }
+            return RS422_RX_READY;
+        } else if (result == FRAME_FEED_BAD_CRC) {
+            return RS422_RX_ERROR;
+        }
+    }
+
+    // Конец кадра по паузе в линии: межбайтовый таймаут по метке последнего байта
+    if (frameDecoderBusy(&rxDecoder) && (uint16_t)(uartTicks() - rxLastStamp) >= uartGapTicks()) {
+        FrameFeedResult result = frameDecoderFinish(&rxDecoder);
+        if (result == FRAME_FEED_COMPLETE && replyMatches(replyCommand)) {
+            return RS422_RX_READY;
+        } else if (result == FRAME_FEED_BAD_CRC) {
+            return RS422_RX_ERROR;
+        }
+        log(LOG_LEVEL_ERROR, "Incomplete response");
+        return RS422_RX_TIMEOUT;
+    }
+    // Таймаут ответа отсчитывается от реального конца передачи кадра и ограничивает
+    // только ожидание первого байта: начатый ответ заканчивается по паузе в линии
+    if (uartTxBusy() || frameDecoderBusy(&rxDecoder)) return RS422_RX_PENDING;
+    if (millis() - uartTxDoneTime() >= timeout) {
+        rxDecoder.count = 0;
+        return RS422_RX_TIMEOUT;
+    }
+    return RS422_RX_PENDING;
+}
+
+// Срочные запросы всегда стоят в голове очереди
+static uint8_t urgentCount() {
+    uint8_t count = 0;
+    while (count < queueCount && queue[count].urgent) count++;
+    return count;
+}
+
+// Последние RS422_URGENT_RESERVE мест очереди — только для срочных команд
+static uint8_t queueLimit(bool urgent) {
+    return urgent ? RS422_QUEUE_SIZE : RS422_QUEUE_SIZE - RS422_URGENT_RESERVE;
+}
+
+// Повтор занимает в очереди место исходного запроса (за срочными) и ждёт паузы, не занимая шину
+static bool requeueForRetry() {
+    if (queueCount >= queueLimit(current.urgent)) return false;
+    uint8_t index = current.urgent ? 0 : urgentCount();
+    memmove(&queue[index + 1], &queue[index], (queueCount - index) * sizeof(Rs422Request));
+    queue[index] = current;
+    queue[index].attempt++;
+    queue[index].notBefore = (uint16_t)millis() + retryBackoff(queue[index].attempt);
+    queueCount++;
+    return true;
+}
+
+static void completeCurrent(Rs422RxStatus status) {
+    inFlight = false;
+    rateWindowFrames++;
+    completeMicros = micros();
+    // Целый ответ освобождает линию сразу; после сбоя или тишины ждём паузы
+    lineDirty = status != RS422_RX_READY || frameDecoderBusy(&rxDecoder);
+    int length = rxDecoder.count;
+    uint16_t latency = (micros() - current.submitTime) / 1000;
+    stats.lastLatency = latency;
+    if (latency > stats.maxLatency) stats.maxLatency = latency;
+    stats.totalLatency += latency;
+
+    // Управляющие команды без ответа считаются переданными; исполнение подтверждает статус ТРК (FSM)
+    if (status == RS422_RX_TIMEOUT && current.replyCommand == 0) status = RS422_RX_READY;
+
+    // Время от конца передачи до первого байта ответа — в оценку таймаутов поста (пробы скорости не в счёт).
+    // Обе метки ставят прерывания, задержка главного цикла в измерение не попадает
+    if (current.replyCommand != 0 && detectRate < 0) {
+        if (status == RS422_RX_READY) {
+            uint16_t ticks = rxFirstStamp - uartTxDoneStamp();
+            rttSample(current.address, current.command, ((uint32_t)ticks << UART_TICK_SHIFT) / 1000);
+        } else if (status == RS422_RX_TIMEOUT) {
+            rttOnTimeout(current.address);
+        }
+        // Ответ с ошибкой CRC тоже показывает, что пост на линии
+        uint32_t bit = 1UL << (current.address - 1);
+        if (status == RS422_RX_TIMEOUT) {
+            postsSeen &= ~bit;
         } else {
-            delayMicroseconds(100);
+            postsSeen |= bit;
+        }
+    }
+
+    if (status == RS422_RX_ERROR) {
+        stats.errors++;
+        log(LOG_LEVEL_ERROR, "CRC mismatch");
+        // Устойчивые ошибки CRC — признак того, что линия не держит скорость
+        if (++crcStreak >= BAUD_FALLBACK_ERRORS && detectRate < 0 && rateIndex + 1 < (int)BAUD_RATE_COUNT) {
+            stats.baudFallbacks++;
+            log(LOG_LEVEL_ERROR, "CRC errors, lowering baud rate");
+            startBaudDetect(rateIndex + 1);
         }
+    } else if (status == RS422_RX_TIMEOUT) {
+        stats.timeouts++;
+    } else {
+        crcStreak = 0;
+    }
+
+    // Неудачный обмен повторяется по политике команды; колбэк получает только итог
+    if (status != RS422_RX_READY && current.retry && retryAllowed(current.command, current.attempt) && requeueForRetry()) {
+        stats.retries++;
+        return;
+    }
+
+    if (status == RS422_RX_READY) {
+        stats.completed++;
+        if (current.attempt) stats.recovered++;
+    } else {
+        stats.exhausted++;
+        if (status == RS422_RX_ERROR) length = -1;
+    }
+    if (current.callback) {
+        current.callback(current.context, status, rxDecoder.buffer, length);
     }
 }
 
-void initRS422() {
-    Serial1.begin(RS422_BAUD_RATE);
+static bool isPriorityPost(uint8_t address) {
+    return (priorityPosts >> (address - 1)) & 1;
 }
 
-void rs422SendStatus() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+static bool isPostSeen(uint8_t address) {
+    return (postsSeen >> (address - 1)) & 1;
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'S', payload, 0, frameBuffer, &frameLength);
+// Планировщик шины: посты с наливом идут первыми, но после
+// BUS_PRIORITY_BURST их запросов подряд очередь уступает остальным постам
+static bool isDue(const Rs422Request* request, uint16_t now) {
+    return request->attempt == 0 || (int16_t)(now - request->notBefore) >= 0;
+}
 
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+static int8_t pickNext() {
+    uint16_t now = millis();
+    int8_t first = -1;
+    int8_t firstPriority = -1;
+    for (uint8_t i = 0; i < queueCount; i++) {
+        if (!isDue(&queue[i], now)) continue;
+        // Запросы, поставленные до подбора скорости, ждут его конца
+        if (detectRate >= 0 && !queue[i].urgent) continue;
+        // Срочные команды стоят в голове очереди и идут раньше любых постов
+        if (queue[i].urgent) return i;
+        if (first < 0) first = i;
+        if (firstPriority < 0 && isPriorityPost(queue[i].address)) firstPriority = i;
+    }
+    if (firstPriority >= 0 && (firstPriority == first || priorityStreak < BUS_PRIORITY_BURST)) {
+        priorityStreak++;
+        return firstPriority;
+    }
+    priorityStreak = 0;
+    return first;
 }
 
-void rs422SendTransaction(FuelMode mode, uint32_t volume, uint32_t amount, uint16_t price) {
-    if (isSending || isReceiving) return;
-    if (price > 9999) {
-        log(LOG_LEVEL_ERROR, "Invalid price");
-        displayMessage("Invalid price");
-        return;
+static bool startNext() {
+    if ((queueCount == 0 && !probePending) || !lineClean()) return false;
+    // Срочные команды уходят и во время подбора скорости, раньше пробного S
+    int8_t index = pickNext();
+    if (index >= 0) {
+        current = queue[index];
+        queueCount--;
+        memmove(&queue[index], &queue[index + 1], (queueCount - index) * sizeof(Rs422Request));
+    } else if (probePending) {
+        current = probe;
+        probePending = false;
+    } else {
+        return false;
     }
-    isSending = true;
 
-    flushInput();
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    char payload[16];
-    switch (mode) {
-        case FUEL_BY_VOLUME:
-            snprintf(payload, sizeof(payload), "V1;%06lu;%04u", volume, price);
-            break;
-        case FUEL_BY_PRICE:
-            snprintf(payload, sizeof(payload), "M1;%06lu;%04u", amount, price);
-            Serial.print("Sending transaction amount: ");
-            Serial.println(amount);
-            break;
-        case FUEL_BY_FULL_TANK:
-            snprintf(payload, sizeof(payload), "M1;999999;%04u", price);
-            break;
+    currentTimeout = current.timeout == RS422_TIMEOUT_ADAPTIVE ? rttTimeout(current.address, current.command) : current.timeout;
+
+    if (!sendFrame(&current)) {
+        rxDecoder.count = 0;
+        completeCurrent(RS422_RX_TIMEOUT);
+        return true;
     }
+    inFlight = true;
+
+    // Оборот шины: от конца прошлого обмена до передачи уже ждавшего запроса
+    if ((long)(current.submitTime - completeMicros) <= 0) {
+        uint32_t turnaround = micros() - completeMicros;
+        stats.lastTurnaround = turnaround;
+        if (turnaround > stats.maxTurnaround) stats.maxTurnaround = turnaround;
+    }
+
+    if (current.urgent && current.attempt == 0) {
+        // Время от нажатия клавиши (постановки в очередь) до записи кадра в линию
+        uint32_t wire = micros() - current.submitTime;
+        stats.urgentSent++;
+        stats.lastKeyToWire = wire;
+        if (wire > stats.maxKeyToWire) stats.maxKeyToWire = wire;
+        if (wire > (uint32_t)BUS_URGENT_DEADLINE * 1000) {
+            stats.urgentLate++;
+            log(LOG_LEVEL_ERROR, "Urgent command late");
+        }
+    }
+    return true;
+}
+
+// Освобождение линии под срочную команду. Кадр, который ещё передаётся,
+// и ответ, который уже идёт, дожидаются конца (не дольше одного кадра):
+// оборванный кадр ТРК не примет, а прерванный ответ пришлось бы запрашивать снова
+static void preemptCurrent() {
+    if (!inFlight || urgentCount() == 0) return;
+    if (uartTxBusy() || frameDecoderBusy(&rxDecoder)) return;
+
+    if (current.replyCommand == 0) {
+        // Управляющая команда (в том числе предыдущая срочная) передана целиком: окно подтверждения сокращается
+        completeCurrent(RS422_RX_TIMEOUT);
+        stats.preempted++;
+        return;
+    }
+    // Ожидание ответа на опрос прерывается; опрос повторится сразу после срочных команд.
+    // Неидемпотентные команды не переотправляются — их ответа дожидаемся.
+    // Прерванный опрос может занять резерв срочных: он вытеснен одной из них
+    if (current.callback == onBaudProbe) {
+        // Пробный S возвращается в своё место и уйдёт после срочных
+        probe = current;
+        probePending = true;
+    } else {
+        const RetryPolicy* policy = retryPolicy(current.command);
+        if (!policy || !policy->idempotent || queueCount >= RS422_QUEUE_SIZE) return;
+        uint8_t index = urgentCount();
+        memmove(&queue[index + 1], &queue[index], (queueCount - index) * sizeof(Rs422Request));
+        queue[index] = current;
+        queueCount++;
+    }
+    inFlight = false;
+    rxDecoder.count = 0;
+    stats.preempted++;
+}
 
-    assembleFrame(slaveAddress, payload[0], (uint8_t*)payload + 1, strlen(payload) - 1, frameBuffer, &frameLength);
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+void initRS422() {
+    initRTT();
+    frameDecoderReset(&rxDecoder, 0);
+    rateWindowStart = millis();
+    startBaudDetect(0);
 }
 
-void rs422SendTransactionUpdate() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+static void fillRequest(Rs422Request* request, uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength,
+                        char replyCommand, uint16_t timeoutMs, Rs422Callback callback, void* context, bool urgent) {
+    request->address = address;
+    request->command = command;
+    request->replyCommand = replyCommand;
+    request->payloadLength = payloadLength;
+    // Без payload данные пишет кодировщик прямо в запрос (message.h)
+    if (payload) memcpy(request->payload, payload, payloadLength);
+    request->timeout = timeoutMs;
+    request->attempt = 0;
+    request->retry = true;
+    request->urgent = urgent;
+    request->submitTime = micros();
+    request->callback = callback;
+    request->context = context;
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'T', payload, 0, frameBuffer, &frameLength);
+static Rs422Request* enqueue(uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength, char replyCommand,
+                             uint16_t timeoutMs, Rs422Callback callback, void* context, bool urgent = false) {
+    if (payloadLength > MAX_FRAME_PAYLOAD) return nullptr;
+    // Скорость линии не подтверждена: FSM повторит запрос в следующем цикле опроса
+    if (detectRate >= 0 && !urgent) return nullptr;
+
+    // Повторный опрос статуса, ещё стоящий в очереди, не дублируется:
+    // ответ получит последний запросивший
+    if (command == 'S') {
+        for (uint8_t i = 0; i < queueCount; i++) {
+            Rs422Request* pending = &queue[i];
+            if (pending->command == 'S' && pending->address == address &&
+                (pending->callback == nullptr || pending->context == context)) {
+                pending->callback = callback;
+                pending->context = context;
+                stats.deduplicated++;
+                return pending;
+            }
+        }
+    }
 
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    delayMicroseconds(500);
-    isSending = false;
+    if (queueCount >= queueLimit(urgent)) {
+        stats.queueFull++;
+        log(LOG_LEVEL_ERROR, "RS422 queue full");
+        return nullptr;
+    }
+    Rs422Request* request = &queue[queueCount];
+    fillRequest(request, address, command, payload, payloadLength, replyCommand, timeoutMs, callback, context, urgent);
+    queueCount++;
+    return request;
 }
 
-void rs422SendNozzleOff() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+// Пробный S очередному посту на проверяемой скорости; место вне очереди, отказа нет
+static void sendBaudProbe() {
+    fillRequest(&probe, POST_ADDRESSES[detectPost], 'S', nullptr, 0, 'S', BAUD_PROBE_TIMEOUT, onBaudProbe, nullptr, false);
+    probe.retry = false;
+    probePending = true;
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'N', payload, 0, frameBuffer, &frameLength);
+// Первый пост для пробы, начиная с index: только ответившие на последний запрос, а пока не ответил никто — все
+static uint8_t nextDetectPost(uint8_t index) {
+    while (index < POST_COUNT && postsSeen && !isPostSeen(POST_ADDRESSES[index])) index++;
+    return index;
+}
 
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+static void setBaudRate(uint8_t index) {
+    rateIndex = index;
+    crcStreak = 0;
+    initUART(RS422_BAUD_RATES[index]);
+    frameDecoderReset(&rxDecoder, 0);
+    lineDirty = false;
 }
 
-void rs422SendLitersMonitor() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+/*
+ * Подбор скорости: S каждому посту, ответившему на последний запрос (после
+ * включения — каждому посту), на каждой скорости, начиная с fromRate и от
+ * быстрой к медленной. Остаётся первая скорость, на которой пришёл ответ с
+ * верной CRC; если не ответил никто — RS422_BAUD_RATE.
+ */
+static void startBaudDetect(uint8_t fromRate) {
+    detectRate = fromRate;
+    detectPost = nextDetectPost(0);
+    setBaudRate(fromRate);
+    sendBaudProbe();
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'L', payload, 0, frameBuffer, &frameLength);
+static void onBaudProbe(void* context, Rs422RxStatus status, const uint8_t* reply, int length) {
+    if (detectRate < 0) return;
+    if (status == RS422_RX_READY) {
+        detectRate = -1;
+        postsSeen |= 1UL << (POST_ADDRESSES[detectPost] - 1);
+        // Оценки времени ответа, набранные на прежней скорости, не годятся
+        initRTT();
+        char text[24];
+        formatUnsigned(appendText(text, "RS422 baud: "), RS422_BAUD_RATES[rateIndex]);
+        log(LOG_LEVEL_DEBUG, text);
+        return;
+    }
+    detectPost = nextDetectPost(detectPost + 1);
+    if (detectPost < POST_COUNT) {
+        sendBaudProbe();
+        return;
+    }
+    detectPost = nextDetectPost(0);
+    if (++detectRate < (int8_t)BAUD_RATE_COUNT) {
+        setBaudRate(detectRate);
+        sendBaudProbe();
+        return;
+    }
+    // Ни один пост не ответил: скорость по умолчанию, дальше связь восстанавливает FSM
+    detectRate = -1;
+    for (uint8_t i = 0; i < BAUD_RATE_COUNT; i++) {
+        if (RS422_BAUD_RATES[i] == RS422_BAUD_RATE) setBaudRate(i);
+    }
+    initRTT();
+    log(LOG_LEVEL_ERROR, "No reply at any baud rate");
+}
 
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+bool rs422Submit(uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength, char replyCommand,
+                 uint16_t timeoutMs, Rs422Callback callback, void* context) {
+    return enqueue(address, command, payload, payloadLength, replyCommand, timeoutMs, callback, context) != nullptr;
 }
 
-void rs422SendRevenueStatus() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+void rs422Service() {
+    // Срочная отправка из колбэка не запускает обход повторно: кадр уйдёт в конце текущего
+    if (servicing) return;
+    servicing = true;
+
+    // Суммарная пропускная способность шины (обменов в секунду)
+    unsigned long now = millis();
+    if (now - rateWindowStart >= 1000) {
+        stats.framesPerSecond = (uint32_t)rateWindowFrames * 1000 / (now - rateWindowStart);
+        rateWindowFrames = 0;
+        rateWindowStart = now;
+    }
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'R', payload, 0, frameBuffer, &frameLength);
+    if (inFlight) {
+        Rs422RxStatus status = pollResponse(current.replyCommand, currentTimeout);
+        if (status == RS422_RX_PENDING) {
+            preemptCurrent();
+        } else {
+            completeCurrent(status);
+        }
+    }
+    // Колбэк мог поставить новый запрос — он уходит в линию сразу
+    while (!inFlight && startNext()) {}
+    servicing = false;
+}
 
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+bool rs422Busy() {
+    return inFlight || queueCount > 0 || probePending;
 }
 
-void rs422SendTotalCounter() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+const Rs422Stats* rs422GetStats() {
+    return &stats;
+}
 
-    flushInput();
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    uint8_t payload[1] = {'1'};
-    assembleFrame(slaveAddress, 'C', payload, 1, frameBuffer, &frameLength);
+void rs422SetPostPriority(uint8_t address, bool dispensing) {
+    uint32_t bit = (uint32_t)1 << (address - 1);
+    if (dispensing) {
+        priorityPosts |= bit;
+    } else {
+        priorityPosts &= ~bit;
+    }
+}
 
-    log(LOG_LEVEL_DEBUG, "Sending C1 command");
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+void rs422ReportStats() {
+    Serial.print("Bus: ");
+    Serial.print(uartBaud());
+    Serial.print(" baud, fallbacks=");
+    Serial.print(stats.baudFallbacks);
+    Serial.print(", ");
+    Serial.print(stats.framesPerSecond);
+    Serial.print(" frames/s, timeouts=");
+    Serial.print(stats.timeouts);
+    Serial.print(", errors=");
+    Serial.print(stats.errors);
+    Serial.print(", retries=");
+    Serial.print(stats.retries);
+    Serial.print(", recovered=");
+    Serial.print(stats.recovered);
+    Serial.print(", exhausted=");
+    Serial.print(stats.exhausted);
+    Serial.print(", max latency=");
+    Serial.print(stats.maxLatency);
+    Serial.print(" ms, turnaround last=");
+    Serial.print(stats.lastTurnaround);
+    Serial.print(" us, max=");
+    Serial.print(stats.maxTurnaround);
+    Serial.println(" us");
+    if (stats.urgentSent) {
+        Serial.print("Urgent: ");
+        Serial.print(stats.urgentSent);
+        Serial.print(" sent, preempted=");
+        Serial.print(stats.preempted);
+        Serial.print(", late=");
+        Serial.print(stats.urgentLate);
+        Serial.print(", key-to-wire last=");
+        Serial.print(stats.lastKeyToWire);
+        Serial.print(" us, max=");
+        Serial.print(stats.maxKeyToWire);
+        Serial.println(" us");
+    }
 }
 
-void rs422SendPause() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+// Опрос без данных: ответ той же командой, таймаут по оценке RTT поста
+static bool submitPoll(uint8_t address, char command, Rs422Callback callback, void* context) {
+    return rs422Submit(address, command, nullptr, 0, command, RS422_TIMEOUT_ADAPTIVE, callback, context);
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'B', payload, 0, frameBuffer, &frameLength);
+// Управляющая команда без данных: ответа нет, ждём окно подтверждения
+static bool submitControl(uint8_t address, char command, Rs422Callback callback, void* context) {
+    return rs422Submit(address, command, nullptr, 0, 0, ACK_TIMEOUT, callback, context);
+}
 
-    log(LOG_LEVEL_DEBUG, "Sending pause command");
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
+bool rs422SendStatus(uint8_t address, Rs422Callback callback, void* context) {
+    return submitPoll(address, 'S', callback, context);
 }
 
-void rs422SendResume() {
-    if (isSending || isReceiving) return;
-    isSending = true;
+bool rs422SendProbe(uint8_t address, Rs422Callback callback, void* context) {
+    // Пробный опрос не повторяется: период проб задаёт режим восстановления FSM
+    Rs422Request* request = enqueue(address, 'S', nullptr, 0, 'S', RS422_TIMEOUT_ADAPTIVE, callback, context);
+    if (request) request->retry = false;
+    return request != nullptr;
+}
 
-    flushInput();
-    uint8_t payload[0];
-    uint8_t frameBuffer[32];
-    int frameLength = 0;
-    assembleFrame(slaveAddress, 'G', payload, 0, frameBuffer, &frameLength);
+bool rs422SendTransaction(uint8_t address, uint8_t nozzle, FuelMode mode, uint32_t quantity, uint16_t price,
+                          Rs422Callback callback, void* context) {
+    if (price > fieldMaxValue(PresetRequest::Price::width)) {
+        log(LOG_LEVEL_ERROR, "Invalid price");
+        return false;
+    }
 
-    log(LOG_LEVEL_DEBUG, "Sending resume command");
-    Serial1.write(frameBuffer, frameLength);
-    Serial1.flush();
-    isSending = false;
-}
-
-int rs422WaitForResponse(uint8_t* buffer, int expectedLength, char expectedCommand) {
-    if (isReceiving) return 0;
-    isReceiving = true;
-
-    int count = 0;
-    unsigned long startTime = millis();
-    unsigned long lastByteTime = startTime;
-
-    while ((millis() - startTime) < RESPONSE_TIMEOUT) {
-        if (Serial1.available() > 0) {
-            buffer[count++] = Serial1.read();
-            lastByteTime = millis();
-            if (count == expectedLength) {
-                if (buffer[0] != 0x02 || buffer[1] != slaveAddress[0] || buffer[2] != slaveAddress[1] || buffer[3] != expectedCommand) {
-                    log(LOG_LEVEL_ERROR, "Invalid response format or command");
-                    displayMessage("Invalid response from pump");
-                    count = -1;
-                    break;
-                }
-                uint8_t calcCRC = calculateCRC(buffer, expectedLength - 1);
-                if (calcCRC != buffer[expectedLength - 1]) {
-                    log(LOG_LEVEL_ERROR, "CRC mismatch");
-                    displayMessage("Invalid response from pump");
-                    count = -1;
-                }
-                break;
-            }
-        } else if (count > 0 && (millis() - lastByteTime) >= INTERBYTE_TIMEOUT) {
-            log(LOG_LEVEL_ERROR, "Incomplete response");
+    char command = 'M';
+    switch (mode) {
+        case FUEL_BY_VOLUME:
+            command = 'V';
+            break;
+        case FUEL_BY_PRICE:
+            Serial.print("Sending transaction amount: ");
+            Serial.println(quantity);
+            break;
+        case FUEL_BY_FULL_TANK:
+            quantity = PRESET_FULL_TANK;
             break;
-        }
     }
 
-    isReceiving = false;
-    return count;
+    Rs422Request* request = enqueue(address, command, nullptr, PresetRequest::payloadLength, 0, ACK_TIMEOUT, callback, context);
+    if (!request) return false;
+    encodePreset(request->payload, nozzle, quantity, price);
+    return true;
+}
+
+bool rs422SendTransactionUpdate(uint8_t address, Rs422Callback callback, void* context) {
+    return submitPoll(address, 'T', callback, context);
+}
+
+bool rs422SendNozzleOff(uint8_t address, Rs422Callback callback, void* context) {
+    return submitControl(address, 'N', callback, context);
+}
+
+bool rs422SubmitUrgent(uint8_t address, char command, Rs422Callback callback, void* context) {
+    // Срочная команда встаёт за уже ждущими срочными, впереди всех остальных
+    uint8_t index = urgentCount();
+    Rs422Request* request = enqueue(address, command, nullptr, 0, 0, ACK_TIMEOUT, callback, context, true);
+    if (!request) return false;
+    Rs422Request urgent = *request;
+    uint8_t last = queueCount - 1;
+    memmove(&queue[index + 1], &queue[index], (last - index) * sizeof(Rs422Request));
+    queue[index] = urgent;
+    // Линия освобождается и кадр уходит сейчас, не дожидаясь следующего прохода loop()
+    rs422Service();
+    return true;
+}
+
+bool rs422SendStop(uint8_t address, Rs422Callback callback, void* context) {
+    log(LOG_LEVEL_DEBUG, "Sending stop command");
+    return rs422SubmitUrgent(address, 'N', callback, context);
+}
+
+bool rs422SendLitersMonitor(uint8_t address, Rs422Callback callback, void* context) {
+    return submitPoll(address, 'L', callback, context);
+}
+
+bool rs422SendRevenueStatus(uint8_t address, Rs422Callback callback, void* context) {
+    return submitPoll(address, 'R', callback, context);
+}
+
+bool rs422SendTotalCounter(uint8_t address, uint8_t nozzle, Rs422Callback callback, void* context) {
+    log(LOG_LEVEL_DEBUG, "Sending C command");
+    Rs422Request* request = enqueue(address, 'C', nullptr, TotalCounterRequest::payloadLength, 'C', RS422_TIMEOUT_ADAPTIVE,
+                                    callback, context);
+    if (!request) return false;
+    encodeTotalCounter(request->payload, nozzle);
+    return true;
+}
+
+bool rs422SendPause(uint8_t address, Rs422Callback callback, void* context) {
+    log(LOG_LEVEL_DEBUG, "Sending pause command");
+    return rs422SubmitUrgent(address, 'B', callback, context);
+}
+
+bool rs422SendResume(uint8_t address, Rs422Callback callback, void* context) {
+    log(LOG_LEVEL_DEBUG, "Sending resume command");
+    return submitControl(address, 'G', callback, context);
 }
\ No newline at end of file
@@ -5,17 +5,140 @@
 #include <stdint.h>
 #include "fsm.h"
 
+typedef enum {
+    RS422_RX_PENDING,   // Ответ ещё не собран, нужно опросить позже
+    RS422_RX_READY,     // Получен полный кадр с верным адресом, командой и CRC
+    RS422_RX_TIMEOUT,   // Ответ не пришёл или оборвался (межбайтовый таймаут)
+    RS422_RX_ERROR      // Кадр собран, но CRC неверна
+} Rs422RxStatus;
+
+/**
+ * Completion callback of a bus request. Called from rs422Service().
+ * @param context Pointer passed to rs422Submit.
+ * @param status RS422_RX_READY, RS422_RX_TIMEOUT or RS422_RX_ERROR.
+ * @param reply Received frame; valid only during the call.
+ * @param length Number of bytes in reply (-1 on CRC error).
+ */
+typedef void (*Rs422Callback)(void* context, Rs422RxStatus status, const uint8_t* reply, int length);
+
+// Статистика обмена по шине
+struct Rs422Stats {
+    uint32_t completed;
+    uint32_t timeouts;
+    uint32_t errors;
+    uint16_t deduplicated;      // Отброшенные повторные опросы S
+    uint16_t queueFull;
+    uint16_t lastLatency;       // От постановки в очередь до завершения (мс)
+    uint16_t maxLatency;
+    uint32_t totalLatency;
+    uint16_t framesPerSecond;   // Обменов в секунду по всем постам
+    uint16_t baudFallbacks;     // Переходов на более низкую скорость из-за ошибок CRC
+    uint32_t lastTurnaround;    // От конца обмена до передачи следующего ждущего запроса (мкс)
+    uint32_t maxTurnaround;
+    uint16_t retries;           // Повторно отправленные запросы
+    uint16_t recovered;         // Запросы, успешные после повтора
+    uint16_t exhausted;         // Запросы, исчерпавшие бюджет повторов
+    uint16_t urgentSent;        // Срочные команды N/B, вышедшие в линию
+    uint16_t urgentLate;        // Из них позже BUS_URGENT_DEADLINE
+    uint16_t preempted;         // Опросы, прерванные ради срочной команды
+    uint32_t lastKeyToWire;     // От нажатия клавиши до записи кадра в линию (мкс)
+    uint32_t maxKeyToWire;
+};
+
+// Таймаут ответа по оценке RTT поста и команды (модуль rtt)
+#define RS422_TIMEOUT_ADAPTIVE 0
+
 void initRS422();
-void rs422SendStatus();
-void rs422SendTransaction(FuelMode mode, uint32_t volume, uint32_t amount, uint16_t price);
-void rs422SendTransactionUpdate();
-void rs422SendNozzleOff();
-void rs422SendLitersMonitor();
-void rs422SendRevenueStatus();
-void rs422SendTotalCounter();
-void rs422SendPause();
-void rs422SendResume();
-int rs422WaitForResponse(uint8_t* buffer, int expectedLength, char expectedCommand); // Обновлено
+
+/**
+ * Queues a bus request. Requests go out one at a time; posts marked as
+ * dispensing are served first, the rest in submission order. A status poll
+ * already waiting in the queue for the same post is reused instead of queued again.
+ * A failed exchange is resent in place per the command's retry policy
+ * (retry.h); the callback sees RS422_RX_TIMEOUT/ERROR only after that.
+ * @param address Post address (1-32).
+ * @param command Command byte.
+ * @param payload Payload bytes (copied).
+ * @param payloadLength Payload length.
+ * @param replyCommand Expected reply command (0 — any frame, silence is not an error).
+ * @param timeoutMs Reply deadline counted from the end of transmission
+ *                  (RS422_TIMEOUT_ADAPTIVE — from the post's round-trip estimate).
+ * @param callback Completion callback (may be nullptr).
+ * @param context Passed to the callback.
+ * @return false if the queue is full or the line rate is being detected
+ *         (after power-up and after repeated CRC errors).
+ */
+bool rs422Submit(uint8_t address, char command, const uint8_t* payload, uint8_t payloadLength, char replyCommand,
+                 uint16_t timeoutMs, Rs422Callback callback, void* context);
+
+/**
+ * Queues an operator command (stop, pause) ahead of all routine traffic
+ * and puts it on the line at once. A poll waiting for its reply is cut
+ * short and re-queued right after the command; a frame still being sent
+ * or a reply already arriving is let through first, so the delay is at
+ * most one frame. The last RS422_URGENT_RESERVE queue slots are kept
+ * for these commands. Key-to-wire time is kept in Rs422Stats.
+ * The pump does not answer N/B: the callback only reports that the frame
+ * went out, and the caller confirms the effect by the pump status.
+ * @param address Post address (1-32).
+ * @param command Command byte without payload ('N', 'B').
+ * @param callback Called once the frame is on the line and its
+ *                 acknowledge window has passed (may be nullptr).
+ * @param context Passed to the callback.
+ * @return false if even the reserved slots are taken.
+ */
+bool rs422SubmitUrgent(uint8_t address, char command, Rs422Callback callback, void* context);
+
+/**
+ * Advances the bus: collects the reply of the request on the line,
+ * runs its callback and starts the next queued request. Never blocks.
+ */
+void rs422Service();
+
+/**
+ * Returns true while a request is on the line or waiting in the queue,
+ * or a baud-rate probe is waiting for the line.
+ */
+bool rs422Busy();
+
+const Rs422Stats* rs422GetStats();
+
+/**
+ * Marks a post as dispensing so the bus scheduler serves its requests first.
+ * @param address Post address (1-32).
+ * @param dispensing true while a transaction is running on the post.
+ */
+void rs422SetPostPriority(uint8_t address, bool dispensing);
+
+/**
+ * Prints bus throughput and error counters to the debug port.
+ */
+void rs422ReportStats();
+
+bool rs422SendStatus(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+
+/**
+ * Status poll of a post that is offline: sent once, without retries.
+ */
+bool rs422SendProbe(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+
+bool rs422SendTransaction(uint8_t address, uint8_t nozzle, FuelMode mode, uint32_t quantity, uint16_t price,
+                          Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendTransactionUpdate(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendNozzleOff(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+
+/**
+ * Stop ('N') requested by the operator: sent through rs422SubmitUrgent.
+ */
+bool rs422SendStop(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendLitersMonitor(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendRevenueStatus(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendTotalCounter(uint8_t address, uint8_t nozzle, Rs422Callback callback = nullptr, void* context = nullptr);
+/**
+ * Pause ('B') requested by the operator: sent through rs422SubmitUrgent.
+ */
+bool rs422SendPause(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
+bool rs422SendResume(uint8_t address, Rs422Callback callback = nullptr, void* context = nullptr);
 void log(int level, const char* msg);
 
 #endif
\ No newline at end of file
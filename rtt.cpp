@@ -0,0 +1,108 @@
+// rtt.cpp
+#include "rtt.h"
+#include "config.h"
+
+// Классы команд с собственной оценкой: S, L/R (монитор), T, C
+#define RTT_CLASS_COUNT 4
+
+// Оценка по Джекобсону: srtt хранится умноженным на 8, отклонение — на 4
+struct RttEstimate {
+    int16_t srtt8;              // 0 — измерений ещё не было
+    int16_t rttvar4;
+};
+
+static RttEstimate estimates[POST_COUNT][RTT_CLASS_COUNT];
+static uint8_t backoff[POST_COUNT];
+
+static const char classNames[RTT_CLASS_COUNT] = {'S', 'L', 'T', 'C'};
+
+static int8_t commandClass(char command) {
+    switch (command) {
+        case 'S': return 0;
+        case 'L':
+        case 'R': return 1;
+        case 'T': return 2;
+        case 'C': return 3;
+        default:  return -1;
+    }
+}
+
+static int8_t postIndex(uint8_t address) {
+    for (uint8_t i = 0; i < POST_COUNT; i++) {
+        if (POST_ADDRESSES[i] == address) return i;
+    }
+    return -1;
+}
+
+static uint16_t clampTimeout(uint32_t timeout) {
+    if (timeout < RTT_TIMEOUT_MIN) return RTT_TIMEOUT_MIN;
+    if (timeout > RTT_TIMEOUT_MAX) return RTT_TIMEOUT_MAX;
+    return timeout;
+}
+
+static uint16_t estimateTimeout(const RttEstimate* e) {
+    if (e->srtt8 == 0) return RTT_TIMEOUT_MAX;
+    // RTO = srtt + 4 * rttvar
+    return clampTimeout((e->srtt8 >> 3) + e->rttvar4);
+}
+
+void initRTT() {
+    memset(estimates, 0, sizeof(estimates));
+    memset(backoff, 0, sizeof(backoff));
+}
+
+void rttSample(uint8_t address, char command, uint16_t rttMs) {
+    int8_t post = postIndex(address);
+    int8_t cls = commandClass(command);
+    if (post < 0 || cls < 0) return;
+    backoff[post] = 0;
+
+    // Ограничение сверху держит srtt8 в 16 битах; ноль зарезервирован под «нет данных»
+    int16_t sample = rttMs > RTT_TIMEOUT_MAX ? RTT_TIMEOUT_MAX : (rttMs ? rttMs : 1);
+    RttEstimate* e = &estimates[post][cls];
+    if (e->srtt8 == 0) {
+        e->srtt8 = sample << 3;
+        e->rttvar4 = sample << 1;
+        if (e->rttvar4 < RTT_GRANULARITY) e->rttvar4 = RTT_GRANULARITY;
+        return;
+    }
+    int16_t err = sample - (e->srtt8 >> 3);
+    e->srtt8 += err;                    // srtt += err / 8
+    if (err < 0) err = -err;
+    e->rttvar4 += err - (e->rttvar4 >> 2); // rttvar += (|err| - rttvar) / 4
+    // При ровных ответах отклонение сходится к нулю и таймаут прижимается к srtt:
+    // первый же ответ чуть медленнее среднего считался бы потерянным
+    if (e->rttvar4 < RTT_GRANULARITY) e->rttvar4 = RTT_GRANULARITY;
+}
+
+void rttOnTimeout(uint8_t address) {
+    int8_t post = postIndex(address);
+    if (post >= 0 && backoff[post] < RTT_MAX_BACKOFF) backoff[post]++;
+}
+
+uint16_t rttTimeout(uint8_t address, char command) {
+    int8_t post = postIndex(address);
+    int8_t cls = commandClass(command);
+    if (post < 0 || cls < 0) return RTT_TIMEOUT_MAX;
+    return clampTimeout((uint32_t)estimateTimeout(&estimates[post][cls]) << backoff[post]);
+}
+
+void rttReport() {
+    for (uint8_t post = 0; post < POST_COUNT; post++) {
+        Serial.print("RTT post ");
+        Serial.print(POST_ADDRESSES[post]);
+        for (uint8_t cls = 0; cls < RTT_CLASS_COUNT; cls++) {
+            const RttEstimate* e = &estimates[post][cls];
+            Serial.print(' ');
+            Serial.print(classNames[cls]);
+            Serial.print(": srtt=");
+            Serial.print(e->srtt8 >> 3);
+            Serial.print(" var=");
+            Serial.print(e->rttvar4 >> 2);
+            Serial.print(" rto=");
+            Serial.print(rttTimeout(POST_ADDRESSES[post], classNames[cls]));
+        }
+        Serial.print(" backoff=");
+        Serial.println(backoff[post]);
+    }
+}
\ No newline at end of file
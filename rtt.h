@@ -0,0 +1,46 @@
+// rtt.h
+#ifndef RTT_H
+#define RTT_H
+
+#include <Arduino.h>
+
+/**
+ * Clears all round-trip estimates; until a post answers, its timeouts
+ * stay at the ceiling RTT_TIMEOUT_MAX.
+ */
+void initRTT();
+
+/**
+ * Feeds a measured round trip (end of transmission to the first reply byte).
+ * Updates the smoothed mean and mean deviation of the post/command pair,
+ * keeping four deviations at least RTT_GRANULARITY, and cancels any
+ * timeout back-off of the post.
+ * @param address Post address (1-32).
+ * @param command Request command byte.
+ * @param rttMs Measured time in milliseconds.
+ */
+void rttSample(uint8_t address, char command, uint16_t rttMs);
+
+/**
+ * Registers a missing reply: the post's timeouts double (up to
+ * RTT_MAX_BACKOFF times) until the next valid sample.
+ * @param address Post address (1-32).
+ */
+void rttOnTimeout(uint8_t address);
+
+/**
+ * Returns the reply timeout for a command: smoothed RTT plus four mean
+ * deviations, scaled by back-off and clamped to RTT_TIMEOUT_MIN..RTT_TIMEOUT_MAX.
+ * Commands without an estimator class get RTT_TIMEOUT_MAX.
+ * @param address Post address (1-32).
+ * @param command Request command byte.
+ * @return Timeout in milliseconds.
+ */
+uint16_t rttTimeout(uint8_t address, char command);
+
+/**
+ * Prints the current estimates of every post to the debug port.
+ */
+void rttReport();
+
+#endif
\ No newline at end of file
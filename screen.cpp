@@ -0,0 +1,116 @@
+// screen.cpp
+#include "screen.h"
+#include "config.h"
+#include "utils.h"
+
+typedef enum : uint8_t {
+    SCREEN_TEXT,                // Постоянный текст
+    SCREEN_MESSAGE,             // Составное сообщение
+    SCREEN_TRANSACTION          // Строка статуса, литры, сумма
+} ScreenContent;
+
+// Модель экрана: области, которые меняют обработчики состояний
+struct ScreenModel {
+    ScreenContent content;
+    DisplayText text;           // SCREEN_TEXT — текст, SCREEN_TRANSACTION — строка статуса
+    bool toastActive;
+    DisplayText toast;
+    uint32_t liters;            // 0.01 л
+    uint32_t money;
+    char message[DISPLAY_TEXT_SIZE];
+};
+
+// Двойная буферизация: back правят обработчики, front — модель кадра на дисплее
+static ScreenModel back;
+static ScreenModel front;
+static unsigned long toastStart = 0;
+static unsigned long lastFrame = 0;
+static bool frameShown = false;
+
+// Статистика компоновщика
+static uint32_t updates = 0;    // Изменений модели
+static uint32_t frames = 0;     // Кадров, переданных дисплею
+
+void screenShowText(DisplayText text) {
+    back.content = SCREEN_TEXT;
+    back.text = text;
+    updates++;
+}
+
+void screenShowMessage(const char* msg) {
+    back.content = SCREEN_MESSAGE;
+    // strncpy дополняет нулями: хвост буфера не мешает сравнению моделей
+    strncpy(back.message, msg, sizeof(back.message) - 1);
+    updates++;
+}
+
+void screenShowTransaction(DisplayText status, uint32_t liters, uint32_t money) {
+    back.content = SCREEN_TRANSACTION;
+    back.text = status;
+    back.liters = liters;
+    back.money = money;
+    updates++;
+}
+
+void screenToast(DisplayText text) {
+    back.toastActive = true;
+    back.toast = text;
+    toastStart = millis();
+    updates++;
+}
+
+// Выводит модель: поверх основной области — всплывающий текст
+static void compose(const ScreenModel* model) {
+    if (model->toastActive) {
+        displayText(model->toast);
+        return;
+    }
+    switch (model->content) {
+        case SCREEN_TEXT:
+            displayText(model->text);
+            break;
+        case SCREEN_MESSAGE:
+            displayMessage(model->message);
+            break;
+        case SCREEN_TRANSACTION: {
+            // Литры с двумя знаками и сумма крупными цифрами под строкой статуса
+            char liters[12];
+            char money[12];
+            formatFixed(liters, model->liters, 2);
+            formatUnsigned(money, model->money);
+            displayFigures(model->text, liters, money);
+            break;
+        }
+    }
+}
+
+// Совпадает ли видимое: под всплывающим текстом изменения основной области не видны
+static bool sameFrame(const ScreenModel* a, const ScreenModel* b) {
+    if (a->toastActive || b->toastActive) {
+        return a->toastActive && b->toastActive && a->toast == b->toast;
+    }
+    return memcmp(a, b, sizeof(ScreenModel)) == 0;
+}
+
+void screenService() {
+    unsigned long now = millis();
+    if (back.toastActive && now - toastStart >= DISPLAY_TOAST_DURATION) {
+        back.toastActive = false;
+    }
+    if (frameShown && now - lastFrame < DISPLAY_FRAME_INTERVAL) return;
+    // Предыдущий кадр ещё рисуется или передаётся: модель подождёт
+    if (oledBusy()) return;
+    if (frameShown && sameFrame(&back, &front)) return;
+    front = back;
+    lastFrame = now;
+    frameShown = true;
+    frames++;
+    compose(&front);
+}
+
+void screenReportStats() {
+    Serial.print("Screen: updates=");
+    Serial.print(updates);
+    Serial.print(", frames=");
+    Serial.println(frames);
+}
\ No newline at end of file
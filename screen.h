@@ -0,0 +1,56 @@
+// screen.h
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <Arduino.h>
+#include "oled.h"
+
+/**
+ * Display compositor. State handlers only update a retained screen model
+ * (main text, or status line with liters and money, plus a transient
+ * toast); screenService() draws it at most once per DISPLAY_FRAME_INTERVAL
+ * and only when it differs from the frame on the display. The model being
+ * edited and the one being drawn are separate copies, so a handler never
+ * touches a frame that is still being sent.
+ */
+
+/**
+ * Main area: one of the fixed texts.
+ * @param text Text identifier.
+ */
+void screenShowText(DisplayText text);
+
+/**
+ * Main area: a composed message ('\n' starts a new line). Copied,
+ * up to DISPLAY_TEXT_SIZE - 1 characters.
+ * @param msg Text to display.
+ */
+void screenShowMessage(const char* msg);
+
+/**
+ * Transaction screen: status line, liters and money.
+ * @param status Status line text.
+ * @param liters Volume in 0.01 l.
+ * @param money Amount as shown on the pump.
+ */
+void screenShowTransaction(DisplayText status, uint32_t liters, uint32_t money);
+
+/**
+ * Shows a text over the main area for DISPLAY_TOAST_DURATION; the main
+ * area keeps updating underneath and reappears when the toast expires.
+ * @param text Text identifier.
+ */
+void screenToast(DisplayText text);
+
+/**
+ * Expires the toast and, once per DISPLAY_FRAME_INTERVAL, hands a changed
+ * model to the display. Never blocks; call from the main loop.
+ */
+void screenService();
+
+/**
+ * Prints model updates and composed frames to the debug port.
+ */
+void screenReportStats();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+// twi.cpp
+#include "twi.h"
+#include "config.h"
+
+// Коды состояния TWSR (биты предделителя сброшены)
+#define TWI_START 0x08
+#define TWI_REP_START 0x10
+#define TWI_SLA_ACK 0x18
+#define TWI_DATA_ACK 0x28
+
+// Текущая транзакция: заголовок копируется, данные читаются из буфера вызывающего
+static uint8_t txAddress;
+static uint8_t txHead[TWI_HEAD_SIZE];
+static uint8_t txHeadLength;
+static const uint8_t* txData;
+static uint8_t txLength;
+static uint8_t txIndex;
+static bool txBusy = false;
+static uint16_t txErrors = 0;
+
+static inline void twiStop() {
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+    txBusy = false;
+}
+
+// Один шаг транзакции по готовому событию шины. TWIE не ставится: обработчик TWI_vect
+// не нужен и не спорит с обработчиком из библиотеки Wire
+static void twiStep() {
+    switch (TWSR & 0xF8) {
+    case TWI_START:
+    case TWI_REP_START:
+        TWDR = txAddress << 1; // SLA+W
+        TWCR = _BV(TWINT) | _BV(TWEN);
+        break;
+    case TWI_SLA_ACK:
+    case TWI_DATA_ACK:
+        // Индекс сквозной: сначала заголовок, затем данные
+        if (txIndex < txHeadLength) {
+            TWDR = txHead[txIndex];
+        } else if (txIndex - txHeadLength < txLength) {
+            TWDR = txData[txIndex - txHeadLength];
+        } else {
+            twiStop();
+            break;
+        }
+        txIndex++;
+        TWCR = _BV(TWINT) | _BV(TWEN);
+        break;
+    default:
+        // Нет подтверждения адреса или данных, потеря арбитража, ошибка шины
+        txErrors++;
+        twiStop();
+        break;
+    }
+}
+
+void initTWI(uint32_t clock) {
+    // Подтяжка линий, как в библиотеке Wire
+    digitalWrite(SDA, HIGH);
+    digitalWrite(SCL, HIGH);
+    TWSR = 0; // Предделитель 1
+    TWBR = (uint8_t)((F_CPU / clock - 16) / 2);
+    TWCR = _BV(TWEN);
+    txBusy = false;
+}
+
+bool twiWrite(uint8_t address, const uint8_t* head, uint8_t headLength, const uint8_t* data, uint8_t length) {
+    if (txBusy || headLength > TWI_HEAD_SIZE) return false;
+    // STOP предыдущей транзакции ещё может выходить на линию
+    while (TWCR & _BV(TWSTO)) {}
+    txAddress = address;
+    memcpy(txHead, head, headLength);
+    txHeadLength = headLength;
+    txData = data;
+    txLength = length;
+    txIndex = 0;
+    txBusy = true;
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTA);
+    return true;
+}
+
+void twiService() {
+    // Шина ещё занята байтом (около 23 мкс на 400 кГц): ждать его не нужно, шаг — при следующем вызове
+    if (txBusy && (TWCR & _BV(TWINT))) twiStep();
+}
+
+bool twiBusy() {
+    twiService();
+    return txBusy;
+}
+
+void twiFlush() {
+    while (twiBusy()) {}
+}
+
+uint16_t twiErrorCount() {
+    return txErrors;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+// twi.h
+#ifndef TWI_H
+#define TWI_H
+
+#include <Arduino.h>
+
+/**
+ * Initializes the TWI (I2C) module as a polled bus master.
+ * Replaces the Wire library for the display: a write transaction is
+ * started and then advanced byte by byte by twiService() from the main
+ * loop. The TWI interrupt stays disabled, so no TWI_vect handler is
+ * defined and the build links alongside the Wire library.
+ * @param clock SCL frequency in hertz (100000 standard, 400000 fast mode).
+ */
+void initTWI(uint32_t clock);
+
+/**
+ * Starts a write transaction and returns immediately: START, address,
+ * the header bytes, the data bytes, STOP. The header is copied; the data
+ * is read straight from the caller's buffer, which must stay unchanged
+ * until twiBusy() returns false.
+ * @param address 7-bit slave address.
+ * @param head Header bytes (e.g. display commands), copied.
+ * @param headLength Header length (up to TWI_HEAD_SIZE).
+ * @param data Data bytes, not copied (may be nullptr).
+ * @param length Data length.
+ * @return false if a transaction is still running (nothing is started).
+ */
+bool twiWrite(uint8_t address, const uint8_t* head, uint8_t headLength, const uint8_t* data, uint8_t length);
+
+/**
+ * Advances the current transaction by one byte if the bus has finished
+ * the previous one; returns at once otherwise. Call from the main loop.
+ */
+void twiService();
+
+/**
+ * Advances the transaction like twiService(), then returns true until
+ * the STOP of the current transaction has been issued.
+ */
+bool twiBusy();
+
+/**
+ * Waits until the current transaction ends.
+ * Blocking; not for use in the main loop path.
+ */
+void twiFlush();
+
+/**
+ * Returns the number of failed transactions (address or data not
+ * acknowledged, arbitration lost, bus error).
+ */
+uint16_t twiErrorCount();
+
+#endif
\ No newline at end of file
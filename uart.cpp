@@ -0,0 +1,184 @@
+// uart.cpp
+#include "uart.h"
+#include "config.h"
+#include <util/atomic.h>
+#include <avr/pgmspace.h>
+
+#define RX_MASK (RS422_RX_BUFFER_SIZE - 1)
+#define TX_MASK (RS422_TX_BUFFER_SIZE - 1)
+
+// Кольцевой буфер приёма: байт и время его прихода
+static volatile uint8_t rxData[RS422_RX_BUFFER_SIZE];
+static volatile uint16_t rxStamp[RS422_RX_BUFFER_SIZE];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+static volatile uint16_t rxErrors = 0;
+
+// Очередь передачи: опустошается прерыванием «регистр данных пуст»
+static volatile uint8_t txData[RS422_TX_BUFFER_SIZE];
+static volatile uint8_t txHead = 0;
+static volatile uint8_t txTail = 0;
+static volatile bool txBusy = false;
+static volatile unsigned long txDoneTime = 0;
+static volatile uint16_t txDoneStamp = 0;       // То же в тиках приёма
+
+// Текущая скорость линии и пауза конца кадра на ней
+static uint32_t lineBaud = 0;
+static uint16_t gapTicks = 1;
+
+ISR(USART1_RX_vect) {
+    uint8_t status = UCSR1A;
+    uint8_t data = UDR1;
+    if (status & (_BV(FE1) | _BV(DOR1) | _BV(UPE1))) {
+        rxErrors++;
+    }
+    uint8_t next = (rxHead + 1) & RX_MASK;
+    if (next == rxTail) {
+        rxErrors++; // Переполнение буфера, байт теряется
+        return;
+    }
+    rxData[rxHead] = data;
+    rxStamp[rxHead] = (uint16_t)(micros() >> UART_TICK_SHIFT);
+    rxHead = next;
+}
+
+ISR(USART1_UDRE_vect) {
+    uint8_t tail = txTail;
+    UCSR1A = (UCSR1A & _BV(U2X1)) | _BV(TXC1); // Сброс флага завершения передачи
+    UDR1 = txData[tail];
+    tail = (tail + 1) & TX_MASK;
+    txTail = tail;
+    if (tail == txHead) {
+        // Последний байт в сдвиговом регистре: ждём прерывания о конце передачи
+        UCSR1B = (UCSR1B & ~_BV(UDRIE1)) | _BV(TXCIE1);
+    }
+}
+
+ISR(USART1_TX_vect) {
+    UCSR1B &= ~_BV(TXCIE1);
+    if (txTail == txHead) {
+        txDoneTime = millis();
+        txDoneStamp = (uint16_t)(micros() >> UART_TICK_SHIFT);
+        txBusy = false;
+    }
+}
+
+void initUART(uint32_t baud) {
+    // Режим двойной скорости, как в HardwareSerial
+    uint16_t ubrr = (F_CPU / 4 / baud - 1) / 2;
+    UCSR1B = 0;
+    UCSR1A = _BV(U2X1);
+    UBRR1H = ubrr >> 8;
+    UBRR1L = ubrr & 0xFF;
+    UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); // 8N1
+    // Символ 8N1 — 10 бит; пауза конца кадра — INTERBYTE_CHARS символов, но не меньше тика
+    lineBaud = baud;
+    gapTicks = (uint16_t)(((uint32_t)INTERBYTE_CHARS * 10 * 1000000 / baud) >> UART_TICK_SHIFT);
+    if (gapTicks == 0) gapTicks = 1;
+    rxHead = rxTail = 0;
+    txHead = txTail = 0;
+    txBusy = false;
+    UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+}
+
+uint16_t uartTicks() {
+    return (uint16_t)(micros() >> UART_TICK_SHIFT);
+}
+
+uint16_t uartMsToTicks(uint16_t ms) {
+    return (uint16_t)(((uint32_t)ms * 1000) >> UART_TICK_SHIFT);
+}
+
+uint32_t uartBaud() {
+    return lineBaud;
+}
+
+uint16_t uartGapTicks() {
+    return gapTicks;
+}
+
+uint8_t uartAvailable() {
+    return (rxHead - rxTail) & RX_MASK;
+}
+
+bool uartRead(uint8_t* data, uint16_t* stamp) {
+    uint8_t tail = rxTail;
+    if (tail == rxHead) return false;
+    *data = rxData[tail];
+    if (stamp) *stamp = rxStamp[tail];
+    rxTail = (tail + 1) & RX_MASK;
+    return true;
+}
+
+void uartClearInput() {
+    rxTail = rxHead;
+}
+
+static bool txHasRoom(uint8_t length) {
+    return length <= ((txTail - txHead - 1) & TX_MASK); // Кадр целиком или ничего
+}
+
+// Публикация записанных байт и запуск передачи
+static void txStart(uint8_t head) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        txHead = head;
+        txBusy = true;
+        UCSR1B = (UCSR1B & ~_BV(TXCIE1)) | _BV(UDRIE1);
+    }
+}
+
+bool uartWrite(const uint8_t* data, uint8_t length) {
+    if (!txHasRoom(length)) return false;
+    if (length == 0) return true;
+    uint8_t head = txHead;
+    for (uint8_t i = 0; i < length; i++) {
+        txData[head] = data[i];
+        head = (head + 1) & TX_MASK;
+    }
+    txStart(head);
+    return true;
+}
+
+bool uartWriteP(const uint8_t* data, uint8_t length) {
+    if (!txHasRoom(length)) return false;
+    if (length == 0) return true;
+    uint8_t head = txHead;
+    for (uint8_t i = 0; i < length; i++) {
+        txData[head] = pgm_read_byte(data + i);
+        head = (head + 1) & TX_MASK;
+    }
+    txStart(head);
+    return true;
+}
+
+bool uartTxBusy() {
+    return txBusy;
+}
+
+unsigned long uartTxDoneTime() {
+    unsigned long t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        t = txDoneTime;
+    }
+    return t;
+}
+
+uint16_t uartTxDoneStamp() {
+    uint16_t t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        t = txDoneStamp;
+    }
+    return t;
+}
+
+void uartFlush() {
+    while (txBusy) {}
+}
+
+uint16_t uartRxErrorCount() {
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = rxErrors;
+    }
+    return count;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+// uart.h
+#ifndef UART_H
+#define UART_H
+
+#include <Arduino.h>
+
+/**
+ * Initializes USART1 (RS-422 line) with interrupt-driven receive.
+ * Received bytes are collected by the RX interrupt into a ring buffer
+ * together with the time they arrived. May be called again to change
+ * the line rate; both buffers are discarded.
+ * @param baud Line rate in bits per second.
+ */
+void initUART(uint32_t baud);
+
+/**
+ * Returns the current line rate in bits per second.
+ */
+uint32_t uartBaud();
+
+/**
+ * Returns the end-of-frame gap in receive ticks: INTERBYTE_CHARS
+ * character times at the current line rate.
+ */
+uint16_t uartGapTicks();
+
+/**
+ * Returns the current time in receive ticks (1 tick = 2^UART_TICK_SHIFT us).
+ */
+uint16_t uartTicks();
+
+/**
+ * Converts milliseconds to receive ticks.
+ * @param ms Interval in milliseconds.
+ * @return Interval in ticks.
+ */
+uint16_t uartMsToTicks(uint16_t ms);
+
+/**
+ * Returns the number of bytes waiting in the receive ring buffer.
+ */
+uint8_t uartAvailable();
+
+/**
+ * Takes one byte from the receive ring buffer.
+ * @param data Output byte.
+ * @param stamp Output arrival time in ticks (may be nullptr).
+ * @return true if a byte was available.
+ */
+bool uartRead(uint8_t* data, uint16_t* stamp);
+
+/**
+ * Discards everything in the receive ring buffer.
+ */
+void uartClearInput();
+
+/**
+ * Queues bytes for transmission and returns immediately.
+ * The queue is drained by the data-register-empty interrupt.
+ * @param data Bytes to send.
+ * @param length Number of bytes.
+ * @return false if the queue has no room for all bytes (nothing is queued).
+ */
+bool uartWrite(const uint8_t* data, uint8_t length);
+
+/**
+ * Same as uartWrite, but the bytes are read from flash (PROGMEM).
+ * @param data Bytes to send, in program memory.
+ * @param length Number of bytes.
+ * @return false if the queue has no room for all bytes (nothing is queued).
+ */
+bool uartWriteP(const uint8_t* data, uint8_t length);
+
+/**
+ * Returns true until the last queued bit has left the transmitter.
+ */
+bool uartTxBusy();
+
+/**
+ * Returns millis() at the moment the last transmission completed.
+ */
+unsigned long uartTxDoneTime();
+
+/**
+ * Returns the moment the last transmission completed in receive ticks,
+ * comparable with the stamps of received bytes.
+ */
+uint16_t uartTxDoneStamp();
+
+/**
+ * Waits until the last queued bit has left the transmitter.
+ * Blocking; not for use in the main loop path.
+ */
+void uartFlush();
+
+/**
+ * Returns the number of receive errors (framing, parity, overrun, ring overflow).
+ */
+uint16_t uartRxErrorCount();
+
+#endif
\ No newline at end of file
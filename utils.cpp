@@ -1,5 +1,104 @@
 #include "utils.h"
 
 void intToString(uint16_t value, uint8_t digits, char* buffer) {
-    snprintf(buffer, digits + 1, "%0*u", digits, value);
+    formatPadded(buffer, value, digits);
+}
+
+/* Разбор цифр: проверка четырёх байт одним 32-битным словом */
+
+// Все четыре байта — '0'..'9': старшая тетрада 3, и после +6 она не переходит в 4
+static bool fourDigits(uint32_t word) {
+    return (word & 0xF0F0F0F0UL) == 0x30303030UL && ((word + 0x06060606UL) & 0xF0F0F0F0UL) == 0x30303030UL;
+}
+
+bool parseFixedDecimal(const uint8_t* src, uint8_t width, uint32_t* value) {
+    uint32_t result = 0;
+    while (width >= 4) {
+        uint32_t word;
+        memcpy(&word, src, 4);
+        if (!fourDigits(word)) return false;
+        // Группа из четырёх цифр копится в 16 битах: на AVR это дешевле 32-битного умножения на цифру
+        uint16_t group = src[0] - '0';
+        group = group * 10 + (src[1] - '0');
+        group = group * 10 + (src[2] - '0');
+        group = group * 10 + (src[3] - '0');
+        result = result * 10000 + group;
+        src += 4;
+        width -= 4;
+    }
+    while (width--) {
+        uint8_t digit = *src++ - '0';
+        if (digit > 9) return false;
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return true;
+}
+
+/* Вывод чисел: без деления 32 бит на каждую цифру */
+
+// Две цифры 0..99: деление на 10 умножением ((v * 103) >> 10 точно для v < 100)
+static void putTwo(char* dst, uint8_t value) {
+    uint8_t tens = ((uint16_t)value * 103) >> 10;
+    dst[0] = '0' + tens;
+    dst[1] = '0' + (value - tens * 10);
+}
+
+// Четыре цифры 0..9999: деление на 100 умножением ((v * 5243) >> 19 точно для v < 43699)
+static void putFour(char* dst, uint16_t value) {
+    uint8_t high = ((uint32_t)value * 5243) >> 19;
+    putTwo(dst, high);
+    putTwo(dst + 2, value - high * 100);
+}
+
+// Все десять цифр uint32_t с ведущими нулями: два 32-битных деления вместо десяти
+static void putTen(char* dst, uint32_t value) {
+    uint32_t high = value / 10000;
+    uint16_t low = value - high * 10000;
+    uint8_t top = high / 10000;
+    uint16_t middle = high - (uint32_t)top * 10000;
+    putTwo(dst, top);
+    putFour(dst + 2, middle);
+    putFour(dst + 6, low);
+}
+
+char* formatUnsigned(char* dst, uint32_t value) {
+    char digits[10];
+    putTen(digits, value);
+    uint8_t first = 0;
+    while (first < 9 && digits[first] == '0') first++;
+    uint8_t count = 10 - first;
+    memcpy(dst, digits + first, count);
+    dst[count] = '\0';
+    return dst + count;
+}
+
+char* formatPadded(char* dst, uint32_t value, uint8_t width) {
+    char digits[10];
+    putTen(digits, value);
+    memcpy(dst, digits + 10 - width, width);
+    dst[width] = '\0';
+    return dst + width;
+}
+
+char* formatFixed(char* dst, uint32_t value, uint8_t fracDigits) {
+    char digits[10];
+    putTen(digits, value);
+    // Целая часть без ведущих нулей, но хотя бы одна цифра
+    uint8_t point = 10 - fracDigits;
+    uint8_t first = 0;
+    while (first < point - 1 && digits[first] == '0') first++;
+    uint8_t intCount = point - first;
+    memcpy(dst, digits + first, intCount);
+    dst += intCount;
+    *dst++ = '.';
+    memcpy(dst, digits + point, fracDigits);
+    dst += fracDigits;
+    *dst = '\0';
+    return dst;
+}
+
+char* appendText(char* dst, const char* src) {
+    while ((*dst = *src++) != '\0') dst++;
+    return dst;
 }
\ No newline at end of file
@@ -11,4 +11,50 @@
  */
 void intToString(uint16_t value, uint8_t digits, char* buffer);
 
+/**
+ * Validates and parses a fixed-width field of ASCII digits in one pass.
+ * Four bytes are checked at a time as one 32-bit word; digits are summed
+ * in 16-bit groups of four, so only one 32-bit multiply runs per group.
+ * @param src Field start (no terminator needed).
+ * @param width Field width in digits (up to 9).
+ * @param value Output value; written only on success.
+ * @return false if any byte of the field is not a digit.
+ */
+bool parseFixedDecimal(const uint8_t* src, uint8_t width, uint32_t* value);
+
+/**
+ * Writes an unsigned integer in decimal without leading zeros.
+ * @param dst Output buffer (at least 11 bytes).
+ * @param value Value.
+ * @return Pointer to the terminating NUL, for appending.
+ */
+char* formatUnsigned(char* dst, uint32_t value);
+
+/**
+ * Writes an unsigned integer padded with leading zeros to a fixed width.
+ * @param dst Output buffer (at least width + 1 bytes).
+ * @param value Value; higher digits that do not fit are dropped.
+ * @param width Number of digits (1-10).
+ * @return Pointer to the terminating NUL, for appending.
+ */
+char* formatPadded(char* dst, uint32_t value, uint8_t width);
+
+/**
+ * Writes a fixed-point value as a decimal: 1234 with two fraction digits
+ * becomes "12.34", 5 becomes "0.05".
+ * @param dst Output buffer (at least 12 bytes).
+ * @param value Value in units of 10^-fracDigits.
+ * @param fracDigits Digits after the point (1-9).
+ * @return Pointer to the terminating NUL, for appending.
+ */
+char* formatFixed(char* dst, uint32_t value, uint8_t fracDigits);
+
+/**
+ * Copies a string and returns the end of the copy.
+ * @param dst Output buffer.
+ * @param src String to append.
+ * @return Pointer to the terminating NUL, for appending.
+ */
+char* appendText(char* dst, const char* src);
+
 #endif
\ No newline at end of file